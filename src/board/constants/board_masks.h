@@ -2,6 +2,8 @@
 
 #include "../types/board_types.h"
 
+MIDNIGHT_NAMESPACE_BEGIN
+
 constexpr array<Bitboard, NFILES> MASK_FILE = {
 		0x101010101010101, 0x202020202020202, 0x404040404040404, 0x808080808080808,
 		0x1010101010101010, 0x2020202020202020, 0x4040404040404040, 0x8080808080808080,
@@ -27,3 +29,8 @@ constexpr array<Bitboard, 15> MASK_ANTI_DIAGONAL= {
 		0x408102040800000, 0x810204080000000, 0x1020408000000000,
 		0x2040800000000000, 0x4080000000000000, 0x8000000000000000,
 };
+
+constexpr Bitboard MASK_DARK_SQUARES	= 0xAA55AA55AA55AA55;
+constexpr Bitboard MASK_LIGHT_SQUARES	= 0x55AA55AA55AA55AA;
+
+MIDNIGHT_NAMESPACE_END
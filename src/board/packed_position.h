@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <vector>
+#include "position.h"
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// A fixed size 34 byte record of a position for binary corpora: one nibble per square from a1 to h8 holding the
+// Piece (low nibble first), a flags byte with the side to move in bit 0 and the castling rights KQkq in bits 1 to 4,
+// and the en passant square or NO_SQUARE. Clocks are not stored, like Position::fen they read back as "0 1".
+struct PackedPosition {
+	static constexpr u8 WHITE_OO = 1 << 1;
+	static constexpr u8 WHITE_OOO = 1 << 2;
+	static constexpr u8 BLACK_OO = 1 << 3;
+	static constexpr u8 BLACK_OOO = 1 << 4;
+
+	std::array<u8, NSQUARES / 2> pieces{};
+	u8 flags = 0;
+	u8 ep_square = NO_SQUARE;
+
+	PackedPosition() = default;
+
+	explicit PackedPosition(const Position& p) {
+		for (Square s = a1; s < NSQUARES; s++) pieces[s / 2] |= static_cast<u8>(p.piece_at(s) << (4 * (s % 2)));
+		flags = static_cast<u8>(p.turn());
+		if (p.king_and_oo_rook_not_moved<WHITE>()) flags |= WHITE_OO;
+		if (p.king_and_ooo_rook_not_moved<WHITE>()) flags |= WHITE_OOO;
+		if (p.king_and_oo_rook_not_moved<BLACK>()) flags |= BLACK_OO;
+		if (p.king_and_ooo_rook_not_moved<BLACK>()) flags |= BLACK_OOO;
+		ep_square = static_cast<u8>(p.ep_square());
+	}
+
+	[[nodiscard]] Piece piece_at(Square s) const { return static_cast<Piece>((pieces[s / 2] >> (4 * (s % 2))) & 0xF); }
+
+	[[nodiscard]] std::string fen() const {
+		std::ostringstream os;
+		for (i32 rank = RANK8; rank >= RANK1; rank--) {
+			i32 empty = 0;
+			for (i32 file = AFILE; file <= HFILE; file++) {
+				const Piece piece = piece_at(create_square(File(file), Rank(rank)));
+				if (piece == NO_PIECE) {
+					empty++;
+					continue;
+				}
+				if (empty) os << empty;
+				empty = 0;
+				os << PIECE_MATCHER[piece];
+			}
+			if (empty) os << empty;
+			if (rank != RANK1) os << '/';
+		}
+		os << (flags & 1 ? " b " : " w ");
+		if (!(flags & (WHITE_OO | WHITE_OOO | BLACK_OO | BLACK_OOO))) os << '-';
+		if (flags & WHITE_OO) os << 'K';
+		if (flags & WHITE_OOO) os << 'Q';
+		if (flags & BLACK_OO) os << 'k';
+		if (flags & BLACK_OOO) os << 'q';
+		if (ep_square == NO_SQUARE) os << " -";
+		else os << " " << SQ_TO_STRING[ep_square];
+		os << " 0 1";
+		return os.str();
+	}
+};
+
+static_assert(sizeof(PackedPosition) == 34);
+
+inline void write_packed(std::ostream& os, const PackedPosition& packed) {
+	os.write(reinterpret_cast<const char*>(&packed), sizeof(PackedPosition));
+}
+
+// Reads records until the end of the stream.
+inline std::vector<PackedPosition> read_packed(std::istream& is) {
+	std::vector<PackedPosition> positions;
+	PackedPosition packed;
+	while (is.read(reinterpret_cast<char*>(&packed), sizeof(PackedPosition))) positions.push_back(packed);
+	return positions;
+}
+
+MIDNIGHT_NAMESPACE_END
@@ -2,14 +2,19 @@
 // Created by Alex Tian on 12/2/2022.
 //
 
+#include <array>
 #include <stdexcept>
 #include <iostream>
 #include <sstream>
 #include "position.h"
+#include "packed_position.h"
 #include "types/bitboard.h"
 #include "constants/misc_constants.h"
 #include "constants/zobrist_constants.h"
 #include "../utils/helpers.h"
+#include "../move_gen/move_generator.h"
+
+MIDNIGHT_NAMESPACE_BEGIN
 
 Position::Position(const std::string& fen) {
 	set_fen(fen);
@@ -20,6 +25,8 @@ void Position::reset() {
 
 	pieces.fill(0);
 	board.fill(NO_PIECE);
+	color_pieces.fill(0);
+	all_pieces = 0;
 
 	side = WHITE;
 }
@@ -27,6 +34,8 @@ void Position::reset() {
 template<bool update_hash>
 void Position::place_piece(Piece piece, Square square) {
 	pieces[piece] |= square_to_bitboard(square);
+	color_pieces[color_of(piece)] |= square_to_bitboard(square);
+	all_pieces |= square_to_bitboard(square);
 	board[square] = piece;
 	if constexpr (update_hash) {
 		state_history.top().hash ^= ZOBRIST_PIECE_SQUARE[piece][square];
@@ -39,6 +48,8 @@ void Position::remove_piece(Square square) {
 		state_history.top().hash ^= ZOBRIST_PIECE_SQUARE[piece_at(square)][square];
 	}
 	pieces[piece_at(square)] &= ~square_to_bitboard(square);
+	color_pieces[color_of(piece_at(square))] &= ~square_to_bitboard(square);
+	all_pieces &= ~square_to_bitboard(square);
 	board[square] = NO_PIECE;
 }
 
@@ -93,25 +104,27 @@ std::string Position::fen() const {
 	return fen.str();
 }
 
-void Position::set_fen(const std::string& fen_string) {
+void Position::set_fen(std::string_view fen_string) {
 	reset();
 
 	// Push empty state to state history.
 	state_history.push({});
 
-	std::vector<std::string> fen_tokens = split(fen_string, " ");
-
-	if (fen_tokens.size() < 4) {
-		throw std::invalid_argument("Fen is missing fields. ");
+	// Fields are read in place, so loading a position does not allocate. The clocks are not read.
+	std::array<std::string_view, 4> fen_tokens;
+	for (usize i = 0; i < fen_tokens.size(); i++) {
+		const usize end = fen_string.find(' ');
+		if (end == std::string_view::npos && i + 1 < fen_tokens.size()) {
+			throw std::invalid_argument("Fen is missing fields. ");
+		}
+		fen_tokens[i] = fen_string.substr(0, end);
+		fen_string.remove_prefix(end == std::string_view::npos ? fen_string.size() : end + 1);
 	}
 
-	const std::string position = fen_tokens[0];
-	const std::string player = fen_tokens[1];
-	const std::string castling = fen_tokens[2];
-	const std::string en_passant = fen_tokens[3];
-
-	const std::string half_move_clock = fen_tokens.size() > 4 ? fen_tokens[4] : "0";
-	const std::string full_move_counter = fen_tokens.size() > 4 ? fen_tokens[5] : "1";
+	const std::string_view position = fen_tokens[0];
+	const std::string_view player = fen_tokens[1];
+	const std::string_view castling = fen_tokens[2];
+	const std::string_view en_passant = fen_tokens[3];
 
 	side = player == "w" ? WHITE : BLACK;
 
@@ -120,27 +133,55 @@ void Position::set_fen(const std::string& fen_string) {
 	Square square = a8;
 
 	for (char ch : position) {
-		if (isdigit(ch)) square += std::stoi(std::string(1, ch)) * EAST;
+		if (isdigit(ch)) square += (ch - '0') * EAST;
 		else if (ch == '/') square += SOUTH_SOUTH;
 		else place_piece<ENABLE_HASH_UPDATE>(piece_from_char(ch), square++);
 	}
 
-	state_history.top().from_to = PositionState::NO_CASTLING_MASK;
+	CastleRight rights = 0;
 	for (char c : castling) {
-		if (c == 'K') 		state_history.top().from_to &= ~PositionState::WHITE_OO_BANNED_MASK;
-		else if (c == 'Q') 	state_history.top().from_to &= ~PositionState::WHITE_OOO_BANNED_MASK;
-		else if (c == 'k') 	state_history.top().from_to &= ~PositionState::BLACK_OO_BANNED_MASK;
-		else if (c == 'q') 	state_history.top().from_to &= ~PositionState::BLACK_OOO_BANNED_MASK;
+		if (c == 'K') 		rights |= WHITE_OO;
+		else if (c == 'Q') 	rights |= WHITE_OOO;
+		else if (c == 'k') 	rights |= BLACK_OO;
+		else if (c == 'q') 	rights |= BLACK_OOO;
 	}
-	state_history.top().hash ^= ZOBRIST_CASTLING_RIGHTS[castling_state(state_history.top().from_to)];
 
-	if (en_passant.size() > 1) {
-		auto s = create_square(File(en_passant[0] - 'a'), Rank(en_passant[1] - '1'));
-		state_history.top().ep_square = s;
-	} else {
-		state_history.top().ep_square = NO_SQUARE;
+	Square ep_square = NO_SQUARE;
+	if (en_passant.size() > 1) ep_square = create_square(File(en_passant[0] - 'a'), Rank(en_passant[1] - '1'));
+	set_castling_and_ep(rights, ep_square);
+}
+
+void Position::set_packed(const PackedPosition& packed) {
+	reset();
+	state_history.push({});
+
+	side = packed.flags & 1 ? BLACK : WHITE;
+	state_history.top().hash ^= ZOBRIST_COLOR[side];
+
+	for (Square s = a1; s < NSQUARES; s++) {
+		const Piece piece = packed.piece_at(s);
+		if (piece != NO_PIECE) place_piece<ENABLE_HASH_UPDATE>(piece, s);
 	}
-	state_history.top().hash ^= ZOBRIST_EP_SQUARE[state_history.top().ep_square];
+
+	CastleRight rights = 0;
+	if (packed.flags & PackedPosition::WHITE_OO) rights |= WHITE_OO;
+	if (packed.flags & PackedPosition::WHITE_OOO) rights |= WHITE_OOO;
+	if (packed.flags & PackedPosition::BLACK_OO) rights |= BLACK_OO;
+	if (packed.flags & PackedPosition::BLACK_OOO) rights |= BLACK_OOO;
+	set_castling_and_ep(rights, static_cast<Square>(packed.ep_square));
+}
+
+void Position::set_castling_and_ep(CastleRight rights, Square ep_square) {
+	PositionState& state = state_history.top();
+	state.from_to = PositionState::NO_CASTLING_MASK;
+	if (rights & WHITE_OO) 	state.from_to &= ~PositionState::WHITE_OO_BANNED_MASK;
+	if (rights & WHITE_OOO) state.from_to &= ~PositionState::WHITE_OOO_BANNED_MASK;
+	if (rights & BLACK_OO) 	state.from_to &= ~PositionState::BLACK_OO_BANNED_MASK;
+	if (rights & BLACK_OOO) state.from_to &= ~PositionState::BLACK_OOO_BANNED_MASK;
+	state.hash ^= ZOBRIST_CASTLING_RIGHTS[castling_state(state.from_to)];
+
+	state.ep_square = ep_square;
+	state.hash ^= ZOBRIST_EP_SQUARE[ep_square];
 }
 
 std::ostream& operator << (std::ostream& os, const Position& p) {
@@ -167,7 +208,7 @@ bool Position::has_repetition(Repetition fold) {
 	const i32 hash_hist_size = static_cast<int>(state_history.size());
 	const u64 current_hash = hash();
 	for (i32 idx = hash_hist_size - 3;
-		 idx >= 0 && idx >= hash_hist_size - fifty_move_rule();
+		 idx >= 0 && idx >= hash_hist_size - 1 - fifty_move_rule();
 		 idx -= 2) {
 		ZobristHash stack_hash = state_history[idx].hash;
 		if (stack_hash == current_hash) count += 1;
@@ -176,6 +217,50 @@ bool Position::has_repetition(Repetition fold) {
 	return false;
 }
 
+bool Position::has_insufficient_material() const {
+	const Bitboard pawns_and_majors = pieces[WHITE_PAWN] | pieces[BLACK_PAWN] |
+									  pieces[WHITE_ROOK] | pieces[BLACK_ROOK] |
+									  pieces[WHITE_QUEEN] | pieces[BLACK_QUEEN];
+	if (pawns_and_majors) return false;
+
+	const Bitboard bishops = pieces[WHITE_BISHOP] | pieces[BLACK_BISHOP];
+	const Bitboard minors = bishops | pieces[WHITE_KNIGHT] | pieces[BLACK_KNIGHT];
+
+	// KvK, KNvK and KBvK.
+	if (pop_count(minors) <= 1) return true;
+
+	// Only bishops left, and all of them on the same colored squares.
+	return minors == bishops && (!(bishops & MASK_LIGHT_SQUARES) || !(bishops & MASK_DARK_SQUARES));
+}
+
+bool Position::in_check() const {
+	if (side == WHITE) return attackers_of<BLACK>(lsb(occupancy<WHITE, KING>()), occupancy());
+	return attackers_of<WHITE>(lsb(occupancy<BLACK, KING>()), occupancy());
+}
+
+bool Position::has_legal_move() {
+	return side == WHITE ? has_any_legal_move<WHITE>(*this) : has_any_legal_move<BLACK>(*this);
+}
+
+bool Position::is_draw(i32 ply) {
+	if (has_insufficient_material()) return true;
+
+	// Checkmate takes precedence over the fifty-move rule.
+	if (fifty_move_rule() >= 100) return !in_check() || has_legal_move();
+
+	int count = 0;
+	const i32 hash_hist_size = static_cast<int>(state_history.size());
+	const u64 current_hash = hash();
+	for (i32 idx = hash_hist_size - 3;
+		 idx >= 0 && idx >= hash_hist_size - 1 - fifty_move_rule();
+		 idx -= 2) {
+		if (state_history[idx].hash != current_hash) continue;
+		if (hash_hist_size - 1 - idx < ply) return true;
+		if (++count >= 2) return true;
+	}
+	return false;
+}
+
 template<Color color>
 void Position::play(Move move) {
 	PositionState next_state = {};
@@ -246,7 +331,7 @@ void Position::undo(Move move) {
 	PositionState old_state = state_history.pop();
 
 	move_piece<DISABLE_HASH_UPDATE>(move.to(), move.from());
-	place_piece<DISABLE_HASH_UPDATE>(old_state.captured, move.to());
+	if (old_state.captured != NO_PIECE) place_piece<DISABLE_HASH_UPDATE>(old_state.captured, move.to());
 
 	MoveType type = move.type();
 	switch (type) {
@@ -317,4 +402,6 @@ template void Position::play_null<WHITE>();
 template void Position::play_null<BLACK>();
 
 template void Position::undo_null<WHITE>();
-template void Position::undo_null<BLACK>();
\ No newline at end of file
+template void Position::undo_null<BLACK>();
+
+MIDNIGHT_NAMESPACE_END
@@ -3,6 +3,7 @@
 //
 #pragma once
 #include <string>
+#include <string_view>
 #include "constants/misc_constants.h"
 #include "../types.h"
 #include "types/bitboard.h"
@@ -12,7 +13,10 @@
 #include "../utils/stack.h"
 #include "../move_gen/tables/attack_tables.h"
 
+MIDNIGHT_NAMESPACE_BEGIN
+
 class Position;
+struct PackedPosition;
 
 class PositionState {
 	friend Position;
@@ -37,13 +41,18 @@ public:
 };
 
 class Position {
+public:
+	// States the history holds, the initial one and one per move played since.
+	static constexpr i16 POSITION_STATE_SIZE = 1000;
+
 private:
 	Color side = WHITE;
 
 	std::array<Bitboard, NPIECES> pieces{};
 	std::array<Piece, NSQUARES> board{};
-
-	static constexpr i16 POSITION_STATE_SIZE = 1000;
+	// Kept up to date by place_piece and remove_piece, so move generation does not rebuild them.
+	std::array<Bitboard, NCOLORS> color_pieces{};
+	Bitboard all_pieces{};
 
 	Stack<PositionState, POSITION_STATE_SIZE> state_history{};
 
@@ -63,6 +72,9 @@ private:
 
 	[[nodiscard]] u8 castling_state(Bitboard from_to) const;
 
+	// Sets the castling rights and en passant square of the first state, for set_fen and set_packed.
+	void set_castling_and_ep(CastleRight rights, Square ep_square);
+
 public:
 	Position() = default;
 	explicit Position(const std::string& fen);
@@ -79,6 +91,16 @@ public:
 	};
 	[[nodiscard]] bool has_repetition(Repetition fold = TWO_FOLD);
 
+	[[nodiscard]] bool has_insufficient_material() const;
+	[[nodiscard]] bool in_check() const;
+	// has_any_legal_move for the side to move.
+	[[nodiscard]] bool has_legal_move();
+
+	// Draw by insufficient material, the fifty-move rule (unless the side to move is mated) or repetition.
+	// `ply` is the distance from the search root. Positions first reached after the root only need to repeat once,
+	// positions from before the root must have occurred twice before.
+	[[nodiscard]] bool is_draw(i32 ply);
+
 	template<Color color>
 	[[nodiscard]] inline bool king_and_oo_rook_not_moved() const {
 		if constexpr (color == WHITE) return !(from_to() & PositionState::WHITE_OO_BANNED_MASK);
@@ -99,19 +121,12 @@ public:
 	template<Piece piece>
 	[[nodiscard]] constexpr Bitboard occupancy() const { return pieces[piece]; }
 
+	[[nodiscard]] constexpr Bitboard occupancy(Piece piece) const { return pieces[piece]; }
+
 	template<Color color>
-	[[nodiscard]] constexpr Bitboard occupancy() const {
-		return 	pieces[make_piece<color, PAWN>()] |
-				pieces[make_piece<color, KNIGHT>()] |
-				pieces[make_piece<color, BISHOP>()] |
-				pieces[make_piece<color, ROOK>()] |
-				pieces[make_piece<color, QUEEN>()] |
-				pieces[make_piece<color, KING>()];
-	}
+	[[nodiscard]] constexpr Bitboard occupancy() const { return color_pieces[color]; }
 
-	[[nodiscard]] inline Bitboard occupancy() {
-		return occupancy<WHITE>() | occupancy<BLACK>();
-	}
+	[[nodiscard]] constexpr Bitboard occupancy() const { return all_pieces; }
 
 	template<Color color>
 	[[nodiscard]] constexpr Bitboard diagonal_sliders() const {
@@ -135,7 +150,9 @@ public:
 		return attackers_of<BLACK>(s, occ) | attackers_of<WHITE>(s, occ);
 	}
 
-	void set_fen(const std::string& fen);
+	void set_fen(std::string_view fen);
+	// Like set_fen without the text parsing. The record is trusted, see PackedPosition.
+	void set_packed(const PackedPosition& packed);
 	[[nodiscard]] std::string fen() const;
 	friend std::ostream& operator<<(std::ostream& os, const Position& p);
 
@@ -151,3 +168,5 @@ public:
 	template<Color color>
 	void undo_null();
 };
+
+MIDNIGHT_NAMESPACE_END
@@ -4,9 +4,16 @@
 #include <stdexcept>
 #include <iostream>
 #include <bitset>
+#include <algorithm>
 #include "../../types.h"
 #include "bitboard.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+MIDNIGHT_NAMESPACE_BEGIN
+
 void print_bitboard(Bitboard bitboard) {
 	std::bitset<64> b(bitboard);
 	std::string str_bitset = b.to_string();
@@ -35,7 +42,6 @@ void print_bitboard(Bitboard bitboard) {
 #elif defined(_MSC_VER) // MSVC
 
 #ifdef _WIN64 // MSVC, WIN64
-#include <intrin.h>
 Square lsb(U64 b) {
 	unsigned long idx;
 	_BitScanForward64(&idx, b);
@@ -49,7 +55,6 @@ Square msb(U64 b) {
 }
 
 #else // MSVC, WIN32
-#include <intrin.h>
 Square lsb(U64 b) {
 	unsigned long idx;
 
@@ -101,3 +106,5 @@ Square msb(U64 b) {
 	bitboard &= bitboard - 1; // compiler optimizes this to _blsr_u64
 	return static_cast<Square>(s);
 }
+
+MIDNIGHT_NAMESPACE_END
@@ -6,6 +6,8 @@
 #include "square.h"
 #include <cassert>
 
+MIDNIGHT_NAMESPACE_BEGIN
+
 void print_bitboard(Bitboard bitboard);
 
 [[nodiscard]] constexpr Bitboard square_to_bitboard(Square square) {
@@ -40,4 +42,6 @@ template<Color C, Direction D>
 [[nodiscard]] Square msb(Bitboard bitboard);
 
 [[nodiscard]] uint32_t pop_count(Bitboard bitboard);
-[[nodiscard]] Square pop_lsb(Bitboard& bitboard);
\ No newline at end of file
+[[nodiscard]] Square pop_lsb(Bitboard& bitboard);
+
+MIDNIGHT_NAMESPACE_END
@@ -1,6 +1,8 @@
 #pragma once
 #include "../../types.h"
 
+MIDNIGHT_NAMESPACE_BEGIN
+
 using ZobristHash = u64;
 using Bitboard = u64;
 
@@ -64,3 +66,5 @@ constexpr CastleRight BLACK_OOO = 0b0001;
 constexpr CastleRight BLACK_OO	= 0b0010;
 constexpr CastleRight WHITE_OOO = 0b0100;
 constexpr CastleRight WHITE_OO	= 0b1000;
+
+MIDNIGHT_NAMESPACE_END
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "../../types.h"
+#include "board_types.h"
+
+MIDNIGHT_NAMESPACE_BEGIN
 
 constexpr u32 NPIECE_TYPES = 7;
 enum PieceType : u32 {
@@ -13,6 +16,13 @@ enum PieceType : u32 {
 	NO_PIECE_TYPE
 };
 
+using PieceTypeSet = u8;
+constexpr PieceTypeSet ALL_PIECE_TYPES = 0b111111;
+
+constexpr PieceTypeSet piece_type_bit(PieceType piece_type) {
+	return static_cast<PieceTypeSet>(1 << piece_type);
+}
+
 constexpr i8 NPIECES = 15;
 enum Piece : u32 {
 	WHITE_PAWN,
@@ -44,6 +54,10 @@ inline PieceType type_of(Piece piece) {
 	return static_cast<PieceType>(piece & 0b000111);
 }
 
+constexpr Color color_of(Piece piece) {
+	return static_cast<Color>(piece >> 3);
+}
+
 inline Piece piece_from_char(char c) {
 	switch (c) {
 		case 'P': return WHITE_PAWN;
@@ -60,4 +74,6 @@ inline Piece piece_from_char(char c) {
 		case 'k': return BLACK_KING;
 		default: return NO_PIECE;
 	}
-}
\ No newline at end of file
+}
+
+MIDNIGHT_NAMESPACE_END
@@ -3,6 +3,8 @@
 #include "../../types.h"
 #include "board_types.h"
 
+MIDNIGHT_NAMESPACE_BEGIN
+
 constexpr i32 NSQUARES = 64;
 
 enum Square : i32 {
@@ -78,3 +80,5 @@ inline const string SQ_TO_STRING[NSQUARES + 1] = {
 		"a8", "b8", "c8", "d8", "e8", "f8", "g8", "h8",
 		"None"
 };
+
+MIDNIGHT_NAMESPACE_END
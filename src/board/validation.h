@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string_view>
+#include "packed_position.h"
+#include "position.h"
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// Checks for positions from outside the program, e.g. of the C API or the server tool. set_fen and set_packed trust
+// their input, and the move generator expects positions a game can reach.
+
+// The fields set_fen reads, which it does not check: 8 ranks of 8 squares, the side to move, castling rights,
+// an en passant square and optionally both clocks. Does not allocate, like set_fen.
+inline bool is_valid_fen(std::string_view fen) {
+	std::array<std::string_view, 7> fields;
+	usize n_fields = 0;
+	while (n_fields < fields.size()) {
+		const usize end = fen.find(' ');
+		fields[n_fields++] = fen.substr(0, end);
+		if (end == std::string_view::npos) break;
+		fen.remove_prefix(end + 1);
+	}
+	if (n_fields != 4 && n_fields != 6) return false;
+
+	i32 ranks = 1, squares = 0;
+	for (char c : fields[0]) {
+		if (c == '/') {
+			if (squares != 8) return false;
+			ranks++;
+			squares = 0;
+		} else if (c >= '1' && c <= '8') {
+			squares += c - '0';
+		} else if (piece_from_char(c) != NO_PIECE) {
+			squares++;
+		} else {
+			return false;
+		}
+	}
+	if (ranks != 8 || squares != 8) return false;
+
+	if (fields[1] != "w" && fields[1] != "b") return false;
+	if (fields[2].empty() || fields[2].size() > 4) return false;
+	if (fields[2] != "-" && fields[2].find_first_not_of("KQkq") != std::string_view::npos) return false;
+	if (fields[3] != "-" && (fields[3].size() != 2 || fields[3][0] < 'a' || fields[3][0] > 'h' ||
+							 (fields[3][1] != '3' && fields[3][1] != '6'))) return false;
+
+	for (usize i = 4; i < n_fields; i++) {
+		if (fields[i].empty() || fields[i].find_first_not_of("0123456789") != std::string_view::npos) return false;
+	}
+	return true;
+}
+
+// Piece codes, flags and en passant square in range. Nibbles 6, 7 and 15 are not pieces, checked 16 squares at a time.
+inline bool is_valid_record(const PackedPosition& packed) {
+	constexpr u64 LOW_BITS = 0x1111111111111111ULL;
+	for (usize i = 0; i < packed.pieces.size(); i += sizeof(u64)) {
+		u64 nibbles;
+		std::memcpy(&nibbles, &packed.pieces[i], sizeof(u64));
+		const u64 bit_0 = nibbles & LOW_BITS, bit_1 = nibbles >> 1 & LOW_BITS;
+		const u64 bit_2 = nibbles >> 2 & LOW_BITS, bit_3 = nibbles >> 3 & LOW_BITS;
+		if (bit_2 & bit_1 & (~bit_3 | bit_0)) return false;
+	}
+	return packed.flags < 1 << 5 && packed.ep_square <= NO_SQUARE;
+}
+
+template<Color color>
+bool has_valid_material(const Position& p) {
+	auto count = [&](PieceType type) { return static_cast<i32>(pop_count(p.occupancy(Piece(color << 3 | type)))); };
+	if (count(KING) != 1) return false;
+	const i32 promoted = std::max(0, count(KNIGHT) - 2) + std::max(0, count(BISHOP) - 2) +
+			std::max(0, count(ROOK) - 2) + std::max(0, count(QUEEN) - 1);
+	return count(PAWN) + promoted <= 8;
+}
+
+template<Color color>
+bool has_valid_castling(const Position& p) {
+	constexpr Square king = color == WHITE ? e1 : e8;
+	constexpr Square oo_rook = color == WHITE ? h1 : h8;
+	constexpr Square ooo_rook = color == WHITE ? a1 : a8;
+	constexpr Piece our_king = make_piece<color, KING>();
+	constexpr Piece our_rook = make_piece<color, ROOK>();
+	if (p.king_and_oo_rook_not_moved<color>() && (p.piece_at(king) != our_king || p.piece_at(oo_rook) != our_rook)) {
+		return false;
+	}
+	return !p.king_and_ooo_rook_not_moved<color>() || (p.piece_at(king) == our_king && p.piece_at(ooo_rook) == our_rook);
+}
+
+// The move generator expects positions a game can reach: a king per side, no pawns on the first and last rank, no
+// more pieces than promotions allow (which keeps the move count under MAX_MOVES), castling rights with the king and
+// rook at home, an en passant square behind a pawn that just moved two squares, and the side not to move not in check.
+inline bool is_valid_position(const Position& p) {
+	if (!has_valid_material<WHITE>(p) || !has_valid_material<BLACK>(p)) return false;
+	if ((p.occupancy<WHITE, PAWN>() | p.occupancy<BLACK, PAWN>()) & (MASK_RANK[RANK1] | MASK_RANK[RANK8])) return false;
+	if (!has_valid_castling<WHITE>(p) || !has_valid_castling<BLACK>(p)) return false;
+
+	const Square ep = p.ep_square();
+	if (ep != NO_SQUARE) {
+		const bool white = p.turn() == WHITE;
+		const Square pushed = white ? ep + SOUTH : ep + NORTH;
+		const Square origin = white ? ep + NORTH : ep + SOUTH;
+		if (rank_of(ep) != (white ? RANK6 : RANK3) || p.piece_at(ep) != NO_PIECE || p.piece_at(origin) != NO_PIECE ||
+			p.piece_at(pushed) != (white ? BLACK_PAWN : WHITE_PAWN)) {
+			return false;
+		}
+	}
+
+	if (p.turn() == WHITE) return !p.attackers_of<WHITE>(lsb(p.occupancy<BLACK, KING>()), p.occupancy());
+	return !p.attackers_of<BLACK>(lsb(p.occupancy<WHITE, KING>()), p.occupancy());
+}
+
+MIDNIGHT_NAMESPACE_END
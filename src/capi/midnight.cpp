@@ -0,0 +1,262 @@
+#include "midnight.h"
+#include "../board/packed_position.h"
+#include "../board/position.h"
+#include "../board/validation.h"
+#include "../move_gen/move_generator.h"
+#include "../move_gen/perft.h"
+#include "../utils/helpers.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <vector>
+
+static_assert(MIDNIGHT_MAX_MOVES == MAX_MOVES);
+// The initial state, the played moves and a perft descent all fit in the state history.
+static_assert(1 + MIDNIGHT_MAX_PLY + MIDNIGHT_MAX_DEPTH < Position::POSITION_STATE_SIZE);
+static_assert(sizeof(midnight_packed_position) == sizeof(PackedPosition));
+
+struct midnight_position {
+	Position position;
+	// Played moves, the last one is taken back first.
+	std::vector<Move> history;
+};
+
+namespace {
+
+midnight_status load(Position& p, const char* fen) {
+	if (!fen) return MIDNIGHT_INVALID_ARGUMENT;
+	if (!is_valid_fen(fen)) return MIDNIGHT_INVALID_POSITION;
+	p.set_fen(fen);
+	return is_valid_position(p) ? MIDNIGHT_OK : MIDNIGHT_INVALID_POSITION;
+}
+
+midnight_status load(Position& p, const midnight_packed_position& record) {
+	PackedPosition packed;
+	std::memcpy(&packed, record.bytes, sizeof(PackedPosition));
+	if (!is_valid_record(packed)) return MIDNIGHT_INVALID_POSITION;
+	p.set_packed(packed);
+	return is_valid_position(p) ? MIDNIGHT_OK : MIDNIGHT_INVALID_POSITION;
+}
+
+// Batch calls load every position into the same position of the calling thread.
+Position& batch_position() {
+	thread_local Position p;
+	return p;
+}
+
+usize legal_moves(Position& p, midnight_move* out) {
+	usize count = 0;
+	auto push = [&](Move move) { out[count++] = move.raw(); };
+	if (p.turn() == WHITE) generate<WHITE>(p, push);
+	else generate<BLACK>(p, push);
+	return count;
+}
+
+u64 perft_nodes(Position& p, i32 depth) {
+	return p.turn() == WHITE ? perft<WHITE>(p, depth) : perft<BLACK>(p, depth);
+}
+
+string uci(Move move) {
+	return SQ_TO_STRING[move.from()] + SQ_TO_STRING[move.to()] + MOVE_TYPE_UCI[move.type()];
+}
+
+// Plays the move when it is one of the legal moves of the position.
+template<typename Matches>
+bool play_legal(midnight_position& handle, Matches&& matches) {
+	if (handle.history.size() >= MIDNIGHT_MAX_PLY) return false;
+	midnight_move moves[MIDNIGHT_MAX_MOVES];
+	const usize count = legal_moves(handle.position, moves);
+	const auto found = std::find_if(moves, moves + count, [&](midnight_move move) { return matches(Move(move)); });
+	if (found == moves + count) return false;
+
+	const Move move(*found);
+	if (handle.position.turn() == WHITE) handle.position.play<WHITE>(move);
+	else handle.position.play<BLACK>(move);
+	handle.history.push_back(move);
+	return true;
+}
+
+// Nothing throws across the interface.
+template<typename Body>
+midnight_status guarded(Body&& body) {
+	try {
+		return body();
+	} catch (const std::bad_alloc&) {
+		return MIDNIGHT_OUT_OF_MEMORY;
+	} catch (...) {
+		return MIDNIGHT_INVALID_ARGUMENT;
+	}
+}
+
+template<typename Input, typename Visit>
+midnight_status for_each_loaded(const Input* positions, usize count, size_t* error_index, Visit&& visit) {
+	if (count && !positions) return MIDNIGHT_INVALID_ARGUMENT;
+	return guarded([&]() {
+		Position& p = batch_position();
+		for (usize i = 0; i < count; i++) {
+			const midnight_status status = load(p, positions[i]);
+			if (status != MIDNIGHT_OK) {
+				if (error_index) *error_index = i;
+				return status;
+			}
+			visit(p, i);
+		}
+		return MIDNIGHT_OK;
+	});
+}
+
+template<typename Input>
+midnight_status generate_batch(const Input* positions, usize count, midnight_move* moves, uint16_t* move_counts,
+							   size_t* error_index) {
+	if (count && (!moves || !move_counts)) return MIDNIGHT_INVALID_ARGUMENT;
+	return for_each_loaded(positions, count, error_index, [&](Position& p, usize i) {
+		move_counts[i] = static_cast<uint16_t>(legal_moves(p, moves + i * MIDNIGHT_MAX_MOVES));
+	});
+}
+
+template<typename Input>
+midnight_status perft_batch(const Input* positions, usize count, int depth, uint64_t* nodes, size_t* error_index) {
+	if (depth < 0 || depth > MIDNIGHT_MAX_DEPTH || (count && !nodes)) return MIDNIGHT_INVALID_ARGUMENT;
+	return for_each_loaded(positions, count, error_index, [&](Position& p, usize i) {
+		nodes[i] = perft_nodes(p, depth);
+	});
+}
+
+midnight_status new_position(midnight_position** out, auto&& load_position) {
+	if (!out) return MIDNIGHT_INVALID_ARGUMENT;
+	*out = nullptr;
+	return guarded([&]() {
+		auto* handle = new midnight_position();
+		const midnight_status status = load_position(handle->position);
+		if (status == MIDNIGHT_OK) *out = handle;
+		else delete handle;
+		return status;
+	});
+}
+
+}
+
+extern "C" {
+
+int midnight_api_version(void) {
+	return MIDNIGHT_API_VERSION;
+}
+
+midnight_status midnight_position_new(const char* fen, midnight_position** out) {
+	return new_position(out, [&](Position& p) { return load(p, fen ? fen : START_FEN.c_str()); });
+}
+
+midnight_status midnight_position_from_packed(const midnight_packed_position* packed, midnight_position** out) {
+	if (!packed) return MIDNIGHT_INVALID_ARGUMENT;
+	return new_position(out, [&](Position& p) { return load(p, *packed); });
+}
+
+void midnight_position_free(midnight_position* position) {
+	delete position;
+}
+
+midnight_status midnight_position_fen(const midnight_position* position, char* buffer, size_t size) {
+	if (!position || !buffer) return MIDNIGHT_INVALID_ARGUMENT;
+	return guarded([&]() {
+		const string fen = position->position.fen();
+		if (fen.size() >= size) return MIDNIGHT_BUFFER_TOO_SMALL;
+		std::memcpy(buffer, fen.c_str(), fen.size() + 1);
+		return MIDNIGHT_OK;
+	});
+}
+
+midnight_status midnight_position_pack(const midnight_position* position, midnight_packed_position* out) {
+	if (!position || !out) return MIDNIGHT_INVALID_ARGUMENT;
+	const PackedPosition packed(position->position);
+	std::memcpy(out->bytes, &packed, sizeof(PackedPosition));
+	return MIDNIGHT_OK;
+}
+
+uint64_t midnight_position_hash(const midnight_position* position) {
+	return position ? position->position.hash() : 0;
+}
+
+size_t midnight_position_ply(const midnight_position* position) {
+	return position ? position->history.size() : 0;
+}
+
+size_t midnight_position_moves(midnight_position* position, midnight_move moves[MIDNIGHT_MAX_MOVES]) {
+	if (!position || !moves) return 0;
+	return legal_moves(position->position, moves);
+}
+
+midnight_status midnight_position_play(midnight_position* position, const midnight_move* moves, size_t count,
+									   size_t* played) {
+	if (played) *played = 0;
+	if (!position || (count && !moves)) return MIDNIGHT_INVALID_ARGUMENT;
+	return guarded([&]() {
+		for (usize i = 0; i < count; i++) {
+			if (!play_legal(*position, [&](Move move) { return move.raw() == moves[i]; })) return MIDNIGHT_ILLEGAL_MOVE;
+			if (played) (*played)++;
+		}
+		return MIDNIGHT_OK;
+	});
+}
+
+midnight_status midnight_position_play_uci(midnight_position* position, const char* moves, size_t* played) {
+	if (played) *played = 0;
+	if (!position || !moves) return MIDNIGHT_INVALID_ARGUMENT;
+	return guarded([&]() {
+		for (const string& token : split(moves, " ")) {
+			if (token.empty()) continue;
+			if (!play_legal(*position, [&](Move move) { return matches_uci(move, token); })) return MIDNIGHT_ILLEGAL_MOVE;
+			if (played) (*played)++;
+		}
+		return MIDNIGHT_OK;
+	});
+}
+
+midnight_status midnight_position_undo(midnight_position* position, size_t count) {
+	if (!position || count > position->history.size()) return MIDNIGHT_INVALID_ARGUMENT;
+	for (usize i = 0; i < count; i++) {
+		const Move move = position->history.back();
+		position->history.pop_back();
+		// The side that played the move is the one not to move now.
+		if (position->position.turn() == WHITE) position->position.undo<BLACK>(move);
+		else position->position.undo<WHITE>(move);
+	}
+	return MIDNIGHT_OK;
+}
+
+midnight_status midnight_position_perft(midnight_position* position, int depth, uint64_t* nodes) {
+	if (!position || !nodes || depth < 0 || depth > MIDNIGHT_MAX_DEPTH) return MIDNIGHT_INVALID_ARGUMENT;
+	*nodes = perft_nodes(position->position, depth);
+	return MIDNIGHT_OK;
+}
+
+midnight_status midnight_move_to_uci(midnight_move move, char* buffer, size_t size) {
+	if (!buffer) return MIDNIGHT_INVALID_ARGUMENT;
+	return guarded([&]() {
+		const string text = uci(Move(move));
+		if (text.size() >= size) return MIDNIGHT_BUFFER_TOO_SMALL;
+		std::memcpy(buffer, text.c_str(), text.size() + 1);
+		return MIDNIGHT_OK;
+	});
+}
+
+midnight_status midnight_generate_fens(const char* const* fens, size_t count, midnight_move* moves,
+									   uint16_t* move_counts, size_t* error_index) {
+	return generate_batch(fens, count, moves, move_counts, error_index);
+}
+
+midnight_status midnight_generate_packed(const midnight_packed_position* positions, size_t count,
+										 midnight_move* moves, uint16_t* move_counts, size_t* error_index) {
+	return generate_batch(positions, count, moves, move_counts, error_index);
+}
+
+midnight_status midnight_perft_fens(const char* const* fens, size_t count, int depth, uint64_t* nodes,
+									size_t* error_index) {
+	return perft_batch(fens, count, depth, nodes, error_index);
+}
+
+midnight_status midnight_perft_packed(const midnight_packed_position* positions, size_t count, int depth,
+									  uint64_t* nodes, size_t* error_index) {
+	return perft_batch(positions, count, depth, nodes, error_index);
+}
+
+}
@@ -0,0 +1,133 @@
+/*
+ * Stable C interface to the move generator for FFI consumers (Python ctypes/cffi, Rust, Go, ...). Only C types
+ * cross it, positions are opaque handles, and nothing throws. The batch calls take N positions as FEN strings or
+ * packed records and fill caller owned arrays, so the per call cost of the foreign function interface is paid once
+ * per batch instead of once per position.
+ *
+ * Functions return MIDNIGHT_OK or a negative midnight_status. Batch calls stop at the first position that fails,
+ * leave the results of the positions before it in place and store its index in error_index when that is not NULL.
+ * Handles are not synchronized, distinct handles and the batch calls can be used from any number of threads.
+ */
+#ifndef MIDNIGHT_CAPI_H
+#define MIDNIGHT_CAPI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define MIDNIGHT_EXPORT __declspec(dllexport)
+#elif defined(__GNUC__)
+#define MIDNIGHT_EXPORT __attribute__((visibility("default")))
+#else
+#define MIDNIGHT_EXPORT
+#endif
+
+/* Incremented on incompatible changes of the functions or types below. */
+#define MIDNIGHT_API_VERSION 1
+
+/* Upper bound of legal moves in a position, the stride of the move arrays of the batch calls. */
+#define MIDNIGHT_MAX_MOVES 218
+/* Moves a handle can play ahead of its initial position. */
+#define MIDNIGHT_MAX_PLY 512
+/* Largest perft depth. Together with MIDNIGHT_MAX_PLY it keeps a search within the state history of a position. */
+#define MIDNIGHT_MAX_DEPTH 64
+/* Buffer size that fits every FEN midnight_position_fen writes, including the terminating NUL. */
+#define MIDNIGHT_FEN_SIZE 128
+/* Buffer size that fits every UCI move midnight_move_to_uci writes, including the terminating NUL. */
+#define MIDNIGHT_UCI_SIZE 6
+
+typedef enum midnight_status {
+	MIDNIGHT_OK = 0,
+	/* A NULL pointer, negative depth or unknown value where a valid one is required. */
+	MIDNIGHT_INVALID_ARGUMENT = -1,
+	/* A malformed FEN or packed record, or a position that cannot be reached, e.g. the side to move gives check. */
+	MIDNIGHT_INVALID_POSITION = -2,
+	/* A move that is not legal in the position it is played in, or more than MIDNIGHT_MAX_PLY moves. */
+	MIDNIGHT_ILLEGAL_MOVE = -3,
+	MIDNIGHT_BUFFER_TOO_SMALL = -4,
+	MIDNIGHT_OUT_OF_MEMORY = -5
+} midnight_status;
+
+/*
+ * A move as 16 bits: the destination square in bits 0 to 5, the origin square in bits 6 to 11 and the move type in
+ * bits 12 to 15. Squares count from a1 = 0 to h8 = 63, castling moves the king two squares. Use the values
+ * generated for a position rather than building moves by hand, or midnight_position_play_uci.
+ */
+typedef uint16_t midnight_move;
+
+/*
+ * The 34 byte record of the corpus tool's binary format: one nibble per square from a1 to h8 with the piece (low
+ * nibble first, 0 to 5 white pawn to king, 8 to 13 black pawn to king, 14 empty), a flags byte with the side to move
+ * in bit 0 and the castling rights KQkq in bits 1 to 4, and the en passant square or 64.
+ */
+typedef struct midnight_packed_position {
+	uint8_t bytes[34];
+} midnight_packed_position;
+
+typedef struct midnight_position midnight_position;
+
+MIDNIGHT_EXPORT int midnight_api_version(void);
+
+/* Creates a handle at the FEN, or at the start position when fen is NULL. */
+MIDNIGHT_EXPORT midnight_status midnight_position_new(const char* fen, midnight_position** out);
+MIDNIGHT_EXPORT midnight_status midnight_position_from_packed(const midnight_packed_position* packed,
+															  midnight_position** out);
+/* Accepts NULL. */
+MIDNIGHT_EXPORT void midnight_position_free(midnight_position* position);
+
+/* Writes the FEN of the current position, which has no clocks and always ends with "0 1". */
+MIDNIGHT_EXPORT midnight_status midnight_position_fen(const midnight_position* position, char* buffer, size_t size);
+MIDNIGHT_EXPORT midnight_status midnight_position_pack(const midnight_position* position, midnight_packed_position* out);
+/* Zobrist hash of the current position, 0 for NULL. */
+MIDNIGHT_EXPORT uint64_t midnight_position_hash(const midnight_position* position);
+/* Number of moves played since the position was created and not undone. */
+MIDNIGHT_EXPORT size_t midnight_position_ply(const midnight_position* position);
+
+/* Writes the legal moves of the current position to moves and returns how many there are, 0 for NULL arguments. */
+MIDNIGHT_EXPORT size_t midnight_position_moves(midnight_position* position, midnight_move moves[MIDNIGHT_MAX_MOVES]);
+/*
+ * Plays count moves in order. Stops at the first move that is not legal and returns MIDNIGHT_ILLEGAL_MOVE, with the
+ * moves before it played. played, when not NULL, receives the number of moves played.
+ */
+MIDNIGHT_EXPORT midnight_status midnight_position_play(midnight_position* position, const midnight_move* moves,
+													   size_t count, size_t* played);
+/* Same as midnight_position_play for moves in UCI notation separated by spaces, e.g. "e2e4 e7e5 g1f3". */
+MIDNIGHT_EXPORT midnight_status midnight_position_play_uci(midnight_position* position, const char* moves,
+														   size_t* played);
+/* Takes back the last count moves, MIDNIGHT_INVALID_ARGUMENT when fewer were played. */
+MIDNIGHT_EXPORT midnight_status midnight_position_undo(midnight_position* position, size_t count);
+/* Number of leaf nodes depth plies below the current position, depth at most MIDNIGHT_MAX_DEPTH. */
+MIDNIGHT_EXPORT midnight_status midnight_position_perft(midnight_position* position, int depth, uint64_t* nodes);
+
+/* Writes the move in UCI notation, e.g. "e7e8q". */
+MIDNIGHT_EXPORT midnight_status midnight_move_to_uci(midnight_move move, char* buffer, size_t size);
+
+/*
+ * Generates the legal moves of count positions. The moves of position i go to
+ * moves[i * MIDNIGHT_MAX_MOVES, i * MIDNIGHT_MAX_MOVES + move_counts[i]), so moves holds
+ * count * MIDNIGHT_MAX_MOVES entries and move_counts count entries.
+ */
+MIDNIGHT_EXPORT midnight_status midnight_generate_fens(const char* const* fens, size_t count, midnight_move* moves,
+													   uint16_t* move_counts, size_t* error_index);
+MIDNIGHT_EXPORT midnight_status midnight_generate_packed(const midnight_packed_position* positions, size_t count,
+														 midnight_move* moves, uint16_t* move_counts,
+														 size_t* error_index);
+
+/*
+ * Perft of count positions to the same depth, at most MIDNIGHT_MAX_DEPTH. The node count of position i goes to
+ * nodes[i].
+ */
+MIDNIGHT_EXPORT midnight_status midnight_perft_fens(const char* const* fens, size_t count, int depth, uint64_t* nodes,
+													size_t* error_index);
+MIDNIGHT_EXPORT midnight_status midnight_perft_packed(const midnight_packed_position* positions, size_t count,
+													  int depth, uint64_t* nodes, size_t* error_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <span>
+#include <algorithm>
+#include "../types.h"
+#include "../board/position.h"
+#include "../utils/stack.h"
+#include "setwise_attacks.h"
+#include "move_generator.h"
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// Number of positions processed together, one 512 bit vector or two 256 bit vectors of bitboards.
+constexpr usize BATCH_LANES = 8;
+
+// Structure of arrays view over up to BATCH_LANES positions, relative to the side to move.
+// Lanes may have different sides to move; `black` is all ones for lanes where black is to move.
+struct BatchBitboards {
+	alignas(64) array<array<Bitboard, BATCH_LANES>, NPIECE_TYPES - 1> us{};
+	alignas(64) array<array<Bitboard, BATCH_LANES>, NPIECE_TYPES - 1> them{};
+	alignas(64) array<Bitboard, BATCH_LANES> black{};
+
+	void load(std::span<const Position> positions) {
+		*this = {};
+		for (usize lane = 0; lane < positions.size(); lane++) {
+			const Position& p = positions[lane];
+			const Color us_color = p.turn();
+			for (u32 pt = PAWN; pt <= KING; pt++) {
+				us[pt][lane] = p.occupancy(Piece((us_color << 3) | pt));
+				them[pt][lane] = p.occupancy(Piece((~us_color << 3) | pt));
+			}
+			black[lane] = us_color == BLACK ? ~0ULL : 0;
+		}
+	}
+};
+
+struct BatchLegality {
+	alignas(64) array<Bitboard, BATCH_LANES> danger{};
+	alignas(64) array<Bitboard, BATCH_LANES> checkers{};
+	alignas(64) array<Bitboard, BATCH_LANES> pinned{};
+
+	[[nodiscard]] LegalityMasks lane(usize i) const { return {danger[i], checkers[i], pinned[i]}; }
+};
+
+namespace batch {
+	// Checkers and pinned pieces along a single ray direction from the king.
+	template<Direction D>
+	inline void king_ray(Bitboard king, Bitboard us_occupancy, Bitboard them_occupancy, Bitboard them_sliders,
+						 Bitboard& checkers, Bitboard& pinned) {
+		// Looking through our own pieces, the ray stops on the first enemy piece.
+		const Bitboard ray = setwise::sliding_attacks<D>(king, ~them_occupancy);
+		const Bitboard slider = ray & them_sliders;
+		const Bitboard blockers = ray & us_occupancy;
+
+		// Branch free versions of slider != 0, blockers == 0 and pop_count(blockers) == 1.
+		const Bitboard has_slider = 0ULL - (slider != 0);
+		const Bitboard no_blockers = 0ULL - (blockers == 0);
+		const Bitboard one_blocker = 0ULL - ((blockers != 0) & ((blockers & (blockers - 1)) == 0));
+
+		checkers |= slider & no_blockers;
+		pinned |= blockers & one_blocker & has_slider;
+	}
+
+	template<Color color>
+	[[nodiscard]] constexpr Bitboard pawn_attacks(Bitboard pawns, Bitboard black) {
+		return (setwise::pawn_attacks<color>(pawns) & ~black) | (setwise::pawn_attacks<~color>(pawns) & black);
+	}
+}
+
+// Computes the danger, checkers and pinned masks of every lane. The loop body is branch free and only
+// uses shifts and bitwise operations, so it is vectorized across lanes when AVX2 or AVX-512 is enabled.
+inline void compute_legality(const BatchBitboards& b, BatchLegality& legality) {
+	// Results are written to a local first, so the compiler knows they do not alias the inputs.
+	BatchLegality out;
+	for (usize lane = 0; lane < BATCH_LANES; lane++) {
+		const Bitboard us_occupancy = b.us[PAWN][lane] | b.us[KNIGHT][lane] | b.us[BISHOP][lane] |
+									  b.us[ROOK][lane] | b.us[QUEEN][lane] | b.us[KING][lane];
+		const Bitboard them_occupancy = b.them[PAWN][lane] | b.them[KNIGHT][lane] | b.them[BISHOP][lane] |
+										b.them[ROOK][lane] | b.them[QUEEN][lane] | b.them[KING][lane];
+		const Bitboard king = b.us[KING][lane];
+		const Bitboard black = b.black[lane];
+
+		const Bitboard them_diag = b.them[BISHOP][lane] | b.them[QUEEN][lane];
+		const Bitboard them_ortho = b.them[ROOK][lane] | b.them[QUEEN][lane];
+
+		// Our pawns attack like white pawns when white is to move, so their pawns attack like black pawns.
+		const Bitboard empty_without_king = ~(us_occupancy | them_occupancy) | king;
+		out.danger[lane] = batch::pawn_attacks<BLACK>(b.them[PAWN][lane], black) |
+						   setwise::knight_attacks(b.them[KNIGHT][lane]) |
+						   setwise::king_attacks(b.them[KING][lane]) |
+						   setwise::bishop_attacks(them_diag, empty_without_king) |
+						   setwise::rook_attacks(them_ortho, empty_without_king);
+
+		Bitboard checkers = (batch::pawn_attacks<WHITE>(king, black) & b.them[PAWN][lane]) |
+							(setwise::knight_attacks(king) & b.them[KNIGHT][lane]);
+		Bitboard pinned = 0;
+
+		batch::king_ray<NORTH>(king, us_occupancy, them_occupancy, them_ortho, checkers, pinned);
+		batch::king_ray<SOUTH>(king, us_occupancy, them_occupancy, them_ortho, checkers, pinned);
+		batch::king_ray<EAST>(king, us_occupancy, them_occupancy, them_ortho, checkers, pinned);
+		batch::king_ray<WEST>(king, us_occupancy, them_occupancy, them_ortho, checkers, pinned);
+		batch::king_ray<NORTH_EAST>(king, us_occupancy, them_occupancy, them_diag, checkers, pinned);
+		batch::king_ray<NORTH_WEST>(king, us_occupancy, them_occupancy, them_diag, checkers, pinned);
+		batch::king_ray<SOUTH_EAST>(king, us_occupancy, them_occupancy, them_diag, checkers, pinned);
+		batch::king_ray<SOUTH_WEST>(king, us_occupancy, them_occupancy, them_diag, checkers, pinned);
+
+		out.checkers[lane] = checkers;
+		out.pinned[lane] = pinned;
+	}
+	legality = out;
+}
+
+// Generates the legal moves of every position into the matching entry of move_lists.
+// Positions are processed BATCH_LANES at a time: danger, checkers and pins are computed for the whole
+// chunk at once, then moves are emitted per position from the precomputed masks. The target squares of each piece are
+// found while emitting, where they are needed with the square the piece moves from.
+template<MoveGenerationType move_gen_type = ALL>
+inline void generate_batch(std::span<Position> positions, std::span<Stack<Move, MAX_MOVES>> move_lists) {
+	BatchBitboards bitboards;
+	BatchLegality legality;
+
+	for (usize base = 0; base < positions.size(); base += BATCH_LANES) {
+		const usize lanes = std::min(BATCH_LANES, positions.size() - base);
+		bitboards.load(positions.subspan(base, lanes));
+		compute_legality(bitboards, legality);
+
+		for (usize lane = 0; lane < lanes; lane++) {
+			Position& p = positions[base + lane];
+			Stack<Move, MAX_MOVES>& list = move_lists[base + lane];
+			list.clear();
+
+			auto push = [&list](Move move) { list.push(move); };
+			if (p.turn() == WHITE) MoveGenerator<WHITE, move_gen_type, decltype(push)>(p, push).generate(legality.lane(lane));
+			else MoveGenerator<BLACK, move_gen_type, decltype(push)>(p, push).generate(legality.lane(lane));
+		}
+	}
+}
+
+MIDNIGHT_NAMESPACE_END
@@ -3,6 +3,8 @@
 #include "../board/types/bitboard.h"
 #include "../board/types/board_types.h"
 
+MIDNIGHT_NAMESPACE_BEGIN
+
 constexpr Bitboard WHITE_OO_BLOCKERS_MASK	= 0x60;
 constexpr Bitboard WHITE_OOO_DANGER_MASK	= 0xC;
 constexpr Bitboard WHITE_OOO_BLOCKERS_MASK	= 0xE;
@@ -27,4 +29,6 @@ template<Color C>
 Bitboard ooo_blockers_mask() {
 	if constexpr (C == WHITE) return WHITE_OOO_BLOCKERS_MASK;
 	return BLACK_OOO_BLOCKERS_MASK;
-}
\ No newline at end of file
+}
+
+MIDNIGHT_NAMESPACE_END
@@ -6,13 +6,48 @@
 #include "tables/attack_tables.h"
 #include "tables/square_tables.h"
 #include "move_gen_masks.h"
+#include "setwise_attacks.h"
+#include "profile.h"
 #include "iostream"
+#include <concepts>
+#include <algorithm>
+#include <type_traits>
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// Visitors that accept a from square together with a bitboard of targets receive moves in batches.
+// Promotion types stand for all four promotions to each target square. In ANY mode the single visit has one target
+// and only says that a legal move exists, a promotion is passed as the queen promotion and stands for itself.
+template<typename Visitor>
+concept BitboardVisitor = requires(Visitor& visitor, Square from, Bitboard to, MoveType type) {
+	visitor.visit(from, to, type);
+};
 
-template<Color color, MoveGenerationType move_gen_type = ALL>
-class MoveList {
+// The legality masks of a position, which every generation call at a node starts from. Build it once and pass
+// it to repeated generation calls there, e.g. captures first and quiet moves later. Invalid once the position changes.
+template<Color color>
+struct GenerationContext {
+	LegalityMasks masks{};
+
+	explicit GenerationContext(Position& board);
+};
+
+// Generates legal moves and hands each of them to the visitor, either one Move at a time through
+// visitor(move), or batched through visitor.visit(from, targets, type) for BitboardVisitors.
+// Filtered generators only generate moves for the pieces selected by a MoveFilter.
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered = false>
+class MoveGenerator {
 private:
-	Stack<Move, 218> move_list{};
 	Position& board_;
+	Visitor& visitor_;
+	// Only pieces standing on these squares are generated for.
+	Bitboard from_mask_ = ~0ULL;
+	bool found_ = false;
+
+	[[nodiscard]] inline Bitboard from_mask() const {
+		if constexpr (filtered) return from_mask_;
+		return ~0ULL;
+	}
 
 	struct SharedData {
 		Bitboard us_occupancy, them_occupancy, all;
@@ -20,10 +55,10 @@ private:
 		Bitboard us_king, them_king;
 		Bitboard us_ortho_sliders, us_diag_sliders;
 		Bitboard them_ortho_sliders, them_diag_sliders;
-		explicit SharedData(Position& board) {
+		explicit SharedData(const Position& board) {
 			us_occupancy = board.occupancy<color>();
 			them_occupancy = board.occupancy<~color>();
-			all = us_occupancy | them_occupancy;
+			all = board.occupancy();
 
 			us_king = board.occupancy<color, KING>();
 			them_king = board.occupancy<~color, KING>();
@@ -40,33 +75,51 @@ private:
 
 	template<MoveType move_type>
 	void push(Square from, Bitboard to) {
-		while (to) {
-			Square to_square = pop_lsb(to);
-			if constexpr (move_type & PROMOTION_TYPE) {
-				constexpr MoveType is_capture = move_type & CAPTURE_TYPE;
-				move_list.push(Move(from, to_square, PR_KNIGHT | is_capture));
-				move_list.push(Move(from, to_square, PR_BISHOP | is_capture));
-				move_list.push(Move(from, to_square, PR_ROOK | is_capture));
-				move_list.push(Move(from, to_square, PR_QUEEN | is_capture));
-			} else {
-				move_list.push(Move(from, to_square, move_type));
-			}
+		if constexpr (move_gen_type == ANY) {
+			if (to) push_single<move_type>(from, lsb(to));
+		} else if constexpr (BitboardVisitor<Visitor>) {
+			if constexpr (MOVEGEN_PROFILE) profile::count_moves(pop_count(to) * (move_type & PROMOTION_TYPE ? 4 : 1));
+			if (to) visitor_.visit(from, to, move_type);
+		} else {
+			while (to) push_single<move_type>(from, pop_lsb(to));
 		}
 	}
 
 	template<MoveType move_type>
 	void push_single(Square from, Square to) {
-		if constexpr (move_type & PROMOTION_TYPE) {
+		if constexpr (move_gen_type == ANY) {
+			// A single representative move is visited, promotions are visited as queen promotions.
+			constexpr MoveType any_type = move_type & PROMOTION_TYPE ? (move_type & CAPTURE_TYPE) | PR_QUEEN : move_type;
+			if (found_) return;
+			found_ = true;
+			if constexpr (MOVEGEN_PROFILE) profile::count_moves(1);
+			if constexpr (BitboardVisitor<Visitor>) visitor_.visit(from, square_to_bitboard(to), any_type);
+			else visitor_(Move(from, to, any_type));
+		} else if constexpr (BitboardVisitor<Visitor>) {
+			if constexpr (MOVEGEN_PROFILE) profile::count_moves(move_type & PROMOTION_TYPE ? 4 : 1);
+			visitor_.visit(from, square_to_bitboard(to), move_type);
+		} else if constexpr (move_type & PROMOTION_TYPE) {
+			if constexpr (MOVEGEN_PROFILE) profile::count_moves(4);
 			constexpr MoveType is_capture = move_type & CAPTURE_TYPE;
-			move_list.push(Move(from, to, PR_KNIGHT | is_capture));
-			move_list.push(Move(from, to, PR_BISHOP | is_capture));
-			move_list.push(Move(from, to, PR_ROOK | is_capture));
-			move_list.push(Move(from, to, PR_QUEEN | is_capture));
+			visitor_(Move(from, to, PR_KNIGHT | is_capture));
+			visitor_(Move(from, to, PR_BISHOP | is_capture));
+			visitor_(Move(from, to, PR_ROOK | is_capture));
+			visitor_(Move(from, to, PR_QUEEN | is_capture));
 		} else {
-			move_list.push(Move(from, to, move_type));
+			if constexpr (MOVEGEN_PROFILE) profile::count_moves(1);
+			visitor_(Move(from, to, move_type));
 		}
 	}
 
+	// In ANY mode at most one legal move is visited, and generation stops once it has been found.
+	[[nodiscard]] inline bool found_any() const {
+		if constexpr (move_gen_type == ANY) return found_;
+		return false;
+	}
+
+	inline void push_all_moves(const SharedData& data, Bitboard danger, Bitboard checkers, Bitboard pinned);
+	inline void push_first_non_king_move(const SharedData& data, Bitboard checkers, Bitboard pinned);
+
 	inline Bitboard generate_danger(const SharedData& data);
 	inline std::pair<Bitboard, Bitboard> generate_checkers_and_pinned(const SharedData& data);
 
@@ -79,18 +132,34 @@ private:
 	inline void push_non_pinned_pawns(const SharedData& data, Bitboard pinned, Bitboard quiet_mask, Bitboard capture_mask);
 	inline void push_promotions(Bitboard pinned, Bitboard quiet_mask, Bitboard capture_mask);
 public:
-	explicit MoveList(Position& board);
+	MoveGenerator(Position& board, Visitor& visitor) : board_{board}, visitor_{visitor} {}
 
-	[[nodiscard]] inline auto begin() const { return move_list.begin(); }
-	[[nodiscard]] inline auto end() const { return move_list.end(); }
-	[[nodiscard]] inline auto size() const { return move_list.size(); }
+	MoveGenerator(Position& board, Visitor& visitor, MoveFilter filter) requires filtered : board_{board}, visitor_{visitor} {
+		from_mask_ = filter.from;
+		if (filter.piece_types == ALL_PIECE_TYPES) return;
+
+		Bitboard piece_type_mask = 0;
+		for (u32 pt = PAWN; pt <= KING; pt++) {
+			if (filter.piece_types & piece_type_bit(PieceType(pt))) piece_type_mask |= board.occupancy(Piece((color << 3) | pt));
+		}
+		from_mask_ &= piece_type_mask;
+	}
+
+	inline void generate();
 
+	// Generates from precomputed danger, checkers and pinned masks, e.g. computed for a whole batch of positions.
+	inline void generate(const LegalityMasks& masks);
+
+	inline void generate(const GenerationContext<color>& context);
+
+	[[nodiscard]] inline LegalityMasks legality_masks();
 };
 
-template<Color color, MoveGenerationType move_gen_type>
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
 inline void
-MoveList<color, move_gen_type>::push_promotions(Bitboard pinned, Bitboard quiet_mask, Bitboard capture_mask) {
-	Bitboard promotion_candidates = board_.occupancy<color, PAWN>() & ~pinned & MASK_RANK[relative_rank<color>(RANK7)];
+MoveGenerator<color, move_gen_type, Visitor, filtered>::push_promotions(Bitboard pinned, Bitboard quiet_mask, Bitboard capture_mask) {
+	[[maybe_unused]] const profile::PhaseScope scope(PHASE_PROMOTIONS);
+	Bitboard promotion_candidates = board_.occupancy<color, PAWN>() & from_mask() & ~pinned & MASK_RANK[relative_rank<color>(RANK7)];
 	if (!promotion_candidates) return;
 
 	Bitboard west_promo_capture = shift_relative<color, NORTH_WEST>(promotion_candidates) & capture_mask;
@@ -115,16 +184,19 @@ MoveList<color, move_gen_type>::push_promotions(Bitboard pinned, Bitboard quiet_
 	}
 }
 
-template<Color color, MoveGenerationType move_gen_type>
-inline void MoveList<color, move_gen_type>::push_check_evasions(const MoveList::SharedData &data, Bitboard danger) {
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline void MoveGenerator<color, move_gen_type, Visitor, filtered>::push_check_evasions(const MoveGenerator::SharedData &data, Bitboard danger) {
+	[[maybe_unused]] const profile::PhaseScope scope(PHASE_EVASIONS);
+	if constexpr (filtered) if (!(data.us_king & from_mask_)) return;
 	Bitboard evasions = tables::attacks<KING>(data.us_king_square, data.all) & ~(data.us_occupancy | danger);
-	if constexpr (move_gen_type == ALL) push<QUIET>(data.us_king_square, evasions & ~data.them_occupancy);
+	if constexpr (move_gen_type != CAPTURES) push<QUIET>(data.us_king_square, evasions & ~data.them_occupancy);
 	push<CAPTURE_TYPE>(data.us_king_square, evasions & data.them_occupancy);
 }
 
-template<Color color, MoveGenerationType move_gen_type>
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
 inline std::pair<Bitboard, Bitboard>
-MoveList<color, move_gen_type>::generate_checkers_and_pinned(const MoveList::SharedData &data) {
+MoveGenerator<color, move_gen_type, Visitor, filtered>::generate_checkers_and_pinned(const MoveGenerator::SharedData &data) {
+	[[maybe_unused]] const profile::PhaseScope scope(PHASE_CHECKERS_AND_PINNED);
 	Bitboard checkers{}, pinned{};
 
 	checkers = (tables::attacks<KNIGHT>(data.us_king_square, data.all) & board_.occupancy<~color, KNIGHT>()) |
@@ -142,13 +214,19 @@ MoveList<color, move_gen_type>::generate_checkers_and_pinned(const MoveList::Sha
 	return {checkers, pinned};
 }
 
-template<Color color, MoveGenerationType move_gen_type>
-inline Bitboard MoveList<color, move_gen_type>::generate_danger(const MoveList::SharedData& data) {
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline Bitboard MoveGenerator<color, move_gen_type, Visitor, filtered>::generate_danger(const MoveGenerator::SharedData& data) {
+	[[maybe_unused]] const profile::PhaseScope scope(PHASE_DANGER);
 	Bitboard danger = board_.occupancy<~color, PAWN>();
 	danger = shift_relative<~color, NORTH_WEST>(danger) | shift_relative<~color, NORTH_EAST>(danger);
 
 	danger |= tables::attacks<KING>(data.them_king_square, data.all);
 
+#ifdef MIDNIGHT_SETWISE_DANGER
+	// Whole side attack sets, no loop over the pieces.
+	danger |= setwise::knight_attacks(board_.occupancy<~color, KNIGHT>());
+	danger |= setwise::slider_attacks(data.them_ortho_sliders, data.them_diag_sliders, ~(data.all ^ data.us_king));
+#else
 	Bitboard them_knights = board_.occupancy<~color, KNIGHT>();
 	while (them_knights) {
 		danger |= tables::attacks<KNIGHT>(pop_lsb(them_knights), data.all);
@@ -163,21 +241,23 @@ inline Bitboard MoveList<color, move_gen_type>::generate_danger(const MoveList::
 	while (them_ortho_sliders_) {
 		danger |= tables::attacks<ROOK>(pop_lsb(them_ortho_sliders_), data.all ^ data.us_king);
 	}
+#endif
 
 	return danger;
 }
 
-template<Color color, MoveGenerationType move_gen_type>
-inline void MoveList<color, move_gen_type>::push_pinned(const MoveList::SharedData &data, Bitboard pinned,
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline void MoveGenerator<color, move_gen_type, Visitor, filtered>::push_pinned(const MoveGenerator::SharedData &data, Bitboard pinned,
 														   Bitboard quiet_mask, Bitboard capture_mask) {
-	Bitboard pinned_pieces = pinned & ~board_.occupancy<color, KNIGHT>() & ~board_.occupancy<color, PAWN>();
-	Bitboard pinned_pawns = pinned & board_.occupancy<color, PAWN>();
+	[[maybe_unused]] const profile::PhaseScope scope(PHASE_PINNED);
+	Bitboard pinned_pieces = pinned & from_mask() & ~board_.occupancy<color, KNIGHT>() & ~board_.occupancy<color, PAWN>();
+	Bitboard pinned_pawns = pinned & from_mask() & board_.occupancy<color, PAWN>();
 
 	while (pinned_pieces) {
 		const Square s = pop_lsb(pinned_pieces);
 		Bitboard pinned_to = tables::attacks(type_of(board_.piece_at(s)), s, data.all) & tables::line_of(data.us_king_square, s);
 
-		if constexpr (move_gen_type == ALL) push<QUIET>(s, pinned_to & quiet_mask);
+		if constexpr (move_gen_type != CAPTURES) push<QUIET>(s, pinned_to & quiet_mask);
 		push<CAPTURE_TYPE>(s, pinned_to & capture_mask);
 	}
 
@@ -205,9 +285,11 @@ inline void MoveList<color, move_gen_type>::push_pinned(const MoveList::SharedDa
 	}
 }
 
-template<Color color, MoveGenerationType move_gen_type>
-inline void MoveList<color, move_gen_type>::push_castle(const MoveList::SharedData &data, Bitboard danger) {
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline void MoveGenerator<color, move_gen_type, Visitor, filtered>::push_castle(const MoveGenerator::SharedData &data, Bitboard danger) {
+	[[maybe_unused]] const profile::PhaseScope scope(PHASE_CASTLE);
 	if constexpr (move_gen_type == CAPTURES) return;
+	if constexpr (filtered) if (!(data.us_king & from_mask_)) return;
 
 	Bitboard oo_path_in_danger = (data.all | danger) & oo_blockers_mask<color>();
 
@@ -224,11 +306,12 @@ inline void MoveList<color, move_gen_type>::push_castle(const MoveList::SharedDa
 	}
 }
 
-template<Color color, MoveGenerationType move_gen_type>
-inline void MoveList<color, move_gen_type>::push_en_passant(const MoveList::SharedData &data, Bitboard pinned) {
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline void MoveGenerator<color, move_gen_type, Visitor, filtered>::push_en_passant(const MoveGenerator::SharedData &data, Bitboard pinned) {
+	[[maybe_unused]] const profile::PhaseScope scope(PHASE_EN_PASSANT);
 	if (board_.ep_square() == NO_SQUARE) return;
 
-	const Bitboard ep_attackers = tables::attacks<PAWN, ~color>(board_.ep_square()) & board_.occupancy<color, PAWN>();
+	const Bitboard ep_attackers = tables::attacks<PAWN, ~color>(board_.ep_square()) & board_.occupancy<color, PAWN>() & from_mask();
 
 	Bitboard unpinned_ep_attackers = ep_attackers & ~pinned;
 
@@ -251,8 +334,9 @@ inline void MoveList<color, move_gen_type>::push_en_passant(const MoveList::Shar
 	}
 }
 
-template<Color color, MoveGenerationType move_gen_type>
-inline bool MoveList<color, move_gen_type>::push_pawn_knight_check_captures(const MoveList::SharedData &data, Bitboard checker, Bitboard pinned) {
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline bool MoveGenerator<color, move_gen_type, Visitor, filtered>::push_pawn_knight_check_captures(const MoveGenerator::SharedData &data, Bitboard checker, Bitboard pinned) {
+	[[maybe_unused]] const profile::PhaseScope scope(PHASE_CHECK_CAPTURES);
 	Square checker_square = lsb(checker);
 
 	Bitboard ep_checker_captures, attacking_checker;
@@ -264,7 +348,7 @@ inline bool MoveList<color, move_gen_type>::push_pawn_knight_check_captures(cons
 			// The checker was a double pushed pawn
 			if (checker == shift_relative<color, SOUTH>(square_to_bitboard(epsq))) {
 				// We can ep capture the double pushed pawn as it is not pinned.
-				ep_checker_captures = tables::attacks<PAWN, ~color>(epsq) & board_.occupancy<color, PAWN>() & ~pinned;
+				ep_checker_captures = tables::attacks<PAWN, ~color>(epsq) & board_.occupancy<color, PAWN>() & from_mask() & ~pinned;
 				while (ep_checker_captures) {
 					push<ENPASSANT>(pop_lsb(ep_checker_captures), square_to_bitboard(epsq));
 				}
@@ -273,7 +357,7 @@ inline bool MoveList<color, move_gen_type>::push_pawn_knight_check_captures(cons
 
 		case make_piece<~color, KNIGHT>():
 			// Checker was a pawn or knight, we must capture (evasions assumed to be handled already)
-			attacking_checker = board_.attackers_of<color>(checker_square, data.all) & ~pinned;
+			attacking_checker = board_.attackers_of<color>(checker_square, data.all) & from_mask() & ~pinned;
 			while (attacking_checker) {
 				Square s = pop_lsb(attacking_checker);
 				// If they promoted to a knight, and we can capture and promote, do that.
@@ -287,41 +371,45 @@ inline bool MoveList<color, move_gen_type>::push_pawn_knight_check_captures(cons
 	}
 }
 
-template<Color color, MoveGenerationType move_gen_type>
-inline void MoveList<color, move_gen_type>::push_non_pinned_pieces(const MoveList::SharedData &data, Bitboard pinned,
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline void MoveGenerator<color, move_gen_type, Visitor, filtered>::push_non_pinned_pieces(const MoveGenerator::SharedData &data, Bitboard pinned,
 																	  Bitboard quiet_mask, Bitboard capture_mask) {
-	Bitboard un_pinned_knights = board_.occupancy<color, KNIGHT>() & ~pinned;
+	[[maybe_unused]] const profile::PhaseScope scope(PHASE_PIECES);
+	Bitboard un_pinned_knights = board_.occupancy<color, KNIGHT>() & from_mask() & ~pinned;
 	while (un_pinned_knights) {
 		Square s = pop_lsb(un_pinned_knights);
 		Bitboard knight_attacks = tables::attacks<KNIGHT>(s, data.all);
-		if constexpr (move_gen_type == ALL) push<QUIET>(s, knight_attacks & quiet_mask);
+		if constexpr (move_gen_type != CAPTURES) push<QUIET>(s, knight_attacks & quiet_mask);
 		push<CAPTURE_TYPE>(s, knight_attacks & capture_mask);
 	}
+	if (found_any()) return;
 
-	Bitboard non_pinned_diag = data.us_diag_sliders & ~pinned;
+	Bitboard non_pinned_diag = data.us_diag_sliders & from_mask() & ~pinned;
 	while (non_pinned_diag) {
 		Square s = pop_lsb(non_pinned_diag);
 		Bitboard non_pinned_diag_attacks = tables::attacks<BISHOP>(s, data.all);
 
-		if constexpr (move_gen_type == ALL) push<QUIET>(s, non_pinned_diag_attacks & quiet_mask);
+		if constexpr (move_gen_type != CAPTURES) push<QUIET>(s, non_pinned_diag_attacks & quiet_mask);
 		push<CAPTURE_TYPE>(s, non_pinned_diag_attacks & capture_mask);
 	}
+	if (found_any()) return;
 
-	Bitboard non_pinned_ortho = data.us_ortho_sliders & ~pinned;
+	Bitboard non_pinned_ortho = data.us_ortho_sliders & from_mask() & ~pinned;
 	while (non_pinned_ortho) {
 		Square s = pop_lsb(non_pinned_ortho);
 		Bitboard non_pinned_ortho_attacks = tables::attacks<ROOK>(s, data.all);
 
-		if constexpr (move_gen_type == ALL) push<QUIET>(s, non_pinned_ortho_attacks & quiet_mask);
+		if constexpr (move_gen_type != CAPTURES) push<QUIET>(s, non_pinned_ortho_attacks & quiet_mask);
 		push<CAPTURE_TYPE>(s, non_pinned_ortho_attacks & capture_mask);
 	}
 }
 
-template<Color color, MoveGenerationType move_gen_type>
-inline void MoveList<color, move_gen_type>::push_non_pinned_pawns(const MoveList::SharedData &data, Bitboard pinned,
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline void MoveGenerator<color, move_gen_type, Visitor, filtered>::push_non_pinned_pawns(const MoveGenerator::SharedData &data, Bitboard pinned,
 																	 Bitboard quiet_mask, Bitboard capture_mask) {
+	[[maybe_unused]] const profile::PhaseScope scope(PHASE_PAWNS);
 
-	Bitboard non_pinned_pawns = board_.occupancy<color, PAWN>() & ~pinned & ~MASK_RANK[relative_rank<color>(RANK7)];
+	Bitboard non_pinned_pawns = board_.occupancy<color, PAWN>() & from_mask() & ~pinned & ~MASK_RANK[relative_rank<color>(RANK7)];
 
 	Bitboard left_pawn_captures = shift_relative<color, NORTH_WEST>(non_pinned_pawns) & capture_mask;
 	Bitboard right_pawn_captures = shift_relative<color, NORTH_EAST>(non_pinned_pawns) & capture_mask;
@@ -335,6 +423,7 @@ inline void MoveList<color, move_gen_type>::push_non_pinned_pawns(const MoveList
 		Square s = pop_lsb(right_pawn_captures);
 		push_single<CAPTURE_TYPE>(s - relative_dir<color, NORTH_EAST>(), s);
 	}
+	if (found_any()) return;
 
 	if constexpr (move_gen_type == CAPTURES) return;
 
@@ -356,17 +445,41 @@ inline void MoveList<color, move_gen_type>::push_non_pinned_pawns(const MoveList
 	}
 }
 
-template<Color color, MoveGenerationType move_gen_type>
-MoveList<color, move_gen_type>::MoveList(Position &board) : board_{board} {
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline void MoveGenerator<color, move_gen_type, Visitor, filtered>::push_first_non_king_move(const MoveGenerator::SharedData &data,
+																							 Bitboard checkers, Bitboard pinned) {
+	// A legal castle implies the king can also step onto the f or d file, so castling never needs to be checked.
+	Bitboard capture_mask, quiet_mask;
+	switch (pop_count(checkers)) {
+		case 2: return;
+		case 1:
+			if (push_pawn_knight_check_captures(data, checkers, pinned)) return;
+			capture_mask = checkers;
+			quiet_mask = tables::square_in_between(data.us_king_square, lsb(checkers));
+			break;
+		default:
+			capture_mask = data.them_occupancy;
+			quiet_mask = ~data.all;
+			break;
+	}
 
-	const SharedData data(board_);
+	push_non_pinned_pawns(data, pinned, quiet_mask, capture_mask);
+	if (found_any()) return;
+	push_promotions(pinned, quiet_mask, capture_mask);
+	if (found_any()) return;
+	push_non_pinned_pieces(data, pinned, quiet_mask, capture_mask);
+	if (found_any() || checkers) return;
 
-	Bitboard danger = generate_danger(data);
+	push_pinned(data, pinned, quiet_mask, capture_mask);
+	if (found_any()) return;
+	push_en_passant(data, pinned);
+}
 
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline void MoveGenerator<color, move_gen_type, Visitor, filtered>::push_all_moves(const MoveGenerator::SharedData &data,
+																				   Bitboard danger, Bitboard checkers, Bitboard pinned) {
 	push_check_evasions(data, danger);
 
-	const auto [checkers, pinned] = generate_checkers_and_pinned(data);
-
 	Bitboard capture_mask, quiet_mask;
 	switch (pop_count(checkers)) {
 		case 2: return;
@@ -387,3 +500,143 @@ MoveList<color, move_gen_type>::MoveList(Position &board) : board_{board} {
 	push_non_pinned_pawns(data, pinned, quiet_mask, capture_mask);
 	push_promotions(pinned, quiet_mask, capture_mask);
 }
+
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline void MoveGenerator<color, move_gen_type, Visitor, filtered>::generate() {
+	[[maybe_unused]] const profile::PhaseScope scope(PHASE_GENERATE);
+	const SharedData data(board_);
+
+	const Bitboard danger = generate_danger(data);
+
+	if constexpr (move_gen_type == ANY) {
+		// King moves are the cheapest to find, checkers and pins are only computed if there are none.
+		push_check_evasions(data, danger);
+		if (found_any()) return;
+
+		const auto [checkers, pinned] = generate_checkers_and_pinned(data);
+		push_first_non_king_move(data, checkers, pinned);
+	} else {
+		const auto [checkers, pinned] = generate_checkers_and_pinned(data);
+		push_all_moves(data, danger, checkers, pinned);
+	}
+}
+
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline void MoveGenerator<color, move_gen_type, Visitor, filtered>::generate(const GenerationContext<color>& context) {
+	generate(context.masks);
+}
+
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline void MoveGenerator<color, move_gen_type, Visitor, filtered>::generate(const LegalityMasks& masks) {
+	[[maybe_unused]] const profile::PhaseScope scope(PHASE_GENERATE);
+	// Occupancies are kept by the position, so rebuilding the shared data is cheaper than storing it.
+	const SharedData data(board_);
+
+	if constexpr (move_gen_type == ANY) {
+		push_check_evasions(data, masks.danger);
+		if (found_any()) return;
+		push_first_non_king_move(data, masks.checkers, masks.pinned);
+	} else {
+		push_all_moves(data, masks.danger, masks.checkers, masks.pinned);
+	}
+}
+
+template<Color color, MoveGenerationType move_gen_type, typename Visitor, bool filtered>
+inline LegalityMasks MoveGenerator<color, move_gen_type, Visitor, filtered>::legality_masks() {
+	const SharedData data(board_);
+	const auto [checkers, pinned] = generate_checkers_and_pinned(data);
+	return {generate_danger(data), checkers, pinned};
+}
+
+template<Color color>
+GenerationContext<color>::GenerationContext(Position& board) {
+	auto ignore = [](Move) {};
+	masks = MoveGenerator<color, ALL, decltype(ignore)>(board, ignore).legality_masks();
+}
+
+template<Color color, MoveGenerationType move_gen_type = ALL, typename Visitor>
+inline void generate(Position& board, Visitor&& visitor) {
+	MoveGenerator<color, move_gen_type, std::remove_reference_t<Visitor>>(board, visitor).generate();
+}
+
+template<Color color, MoveGenerationType move_gen_type = ALL, typename Visitor>
+inline void generate(Position& board, Visitor&& visitor, MoveFilter filter) {
+	MoveGenerator<color, move_gen_type, std::remove_reference_t<Visitor>, true>(board, visitor, filter).generate();
+}
+
+template<Color color, MoveGenerationType move_gen_type = ALL, typename Visitor>
+inline void generate(Position& board, const GenerationContext<color>& context, Visitor&& visitor) {
+	MoveGenerator<color, move_gen_type, std::remove_reference_t<Visitor>>(board, visitor).generate(context);
+}
+
+// Entry is the stored element, either a bare Move or a ScoredMove for lists that carry ordering scores.
+template<Color color, MoveGenerationType move_gen_type = ALL, typename Entry = Move>
+class MoveList {
+private:
+	Stack<Entry, MAX_MOVES> move_list{};
+public:
+	explicit MoveList(Position& board) {
+		generate<color, move_gen_type>(board, [this](Move move) { move_list.push(move); });
+	}
+
+	MoveList(Position& board, MoveFilter filter) {
+		generate<color, move_gen_type>(board, [this](Move move) { move_list.push(move); }, filter);
+	}
+
+	MoveList(Position& board, const GenerationContext<color>& context) {
+		generate<color, move_gen_type>(board, context, [this](Move move) { move_list.push(move); });
+	}
+
+	[[nodiscard]] inline auto begin() const { return move_list.begin(); }
+	[[nodiscard]] inline auto end() const { return move_list.end(); }
+	[[nodiscard]] inline auto size() const { return move_list.size(); }
+
+	[[nodiscard]] inline auto begin() { return move_list.begin(); }
+	[[nodiscard]] inline auto end() { return move_list.end(); }
+
+	[[nodiscard]] inline Entry& operator[](usize i) { return move_list[i]; }
+	[[nodiscard]] inline Entry operator[](usize i) const { return move_list[i]; }
+
+	// Assigns every move the score returned by scorer(move).
+	template<typename Scorer> requires std::same_as<Entry, ScoredMove>
+	inline void score(Scorer&& scorer) {
+		for (ScoredMove& entry : move_list) entry.set_score(scorer(entry.move()));
+	}
+
+	// One step of a selection sort: moves the highest scoring entry in [start, size) to start and returns it, or the
+	// null Move() once the list is exhausted. Entries compare as plain integers, so the max reduction vectorizes.
+	inline Move pick_best(usize start) requires std::same_as<Entry, ScoredMove> {
+		if (start >= size()) return Move();
+		ScoredMove* entries = &move_list[0];
+		u32 best = 0;
+		for (usize i = start; i < size(); i++) best = std::max(best, entries[i].raw());
+
+		usize best_idx = start;
+		while (entries[best_idx].raw() != best) best_idx++;
+
+		std::swap(entries[start], entries[best_idx]);
+		return entries[start].move();
+	}
+};
+
+template<Color color, MoveGenerationType move_gen_type = ALL>
+using ScoredMoveList = MoveList<color, move_gen_type, ScoredMove>;
+
+// Whether color has a legal move, generation stops at the first one. Position::has_legal_move asks the same for the
+// side to move.
+template<Color color>
+[[nodiscard]] inline bool has_any_legal_move(Position& board) {
+	return MoveList<color, ANY>(board).size() != 0;
+}
+
+template<Color color>
+[[nodiscard]] inline bool is_checkmate(Position& board) {
+	return board.in_check() && !has_any_legal_move<color>(board);
+}
+
+template<Color color>
+[[nodiscard]] inline bool is_stalemate(Position& board) {
+	return !board.in_check() && !has_any_legal_move<color>(board);
+}
+
+MIDNIGHT_NAMESPACE_END
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include "../board/packed_position.h"
+#include "../board/position.h"
+#include "../utils/stack.h"
+#include "../utils/thread_pool.h"
+#include "move_generator.h"
+#include "perft.h"
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// Inputs of for_each_position: FENs (std::string, std::string_view, const char*) or packed records. They are trusted
+// like in set_fen and set_packed, see src/board/validation.h for input from outside the program.
+inline void load_position(Position& p, std::string_view fen) { p.set_fen(fen); }
+inline void load_position(Position& p, const PackedPosition& packed) { p.set_packed(packed); }
+
+template<typename Input>
+concept PositionInput = requires(Position& p, const Input& input) { load_position(p, input); };
+
+template<typename Inputs>
+concept PositionInputs = std::ranges::random_access_range<const Inputs> && std::ranges::sized_range<const Inputs> &&
+		PositionInput<std::ranges::range_value_t<const Inputs>>;
+
+namespace parallel {
+	// Inputs a task loads one after another into the position of its worker.
+	constexpr usize CHUNK_SIZE = 64;
+}
+
+// Calls visit(p, i) for every input i on the workers of the pool, with p set to the position of the input. Every worker
+// loads its inputs into one Position of its own, so no position (with its 1000 entry state history) is constructed
+// per input. The inputs are split into chunks with parallel_for, so idle workers steal large ranges of chunks from
+// busy ones. visit runs concurrently and writes the result of input i to index i of a buffer sized before the call,
+// e.g.
+//     std::vector<u8> in_check(fens.size());
+//     for_each_position(pool, fens, [&](Position& p, usize i) { in_check[i] = p.in_check(); });
+// visit may change p but must not wait on the pool, another chunk run meanwhile would load its inputs into p. The
+// first exception thrown by loading an input or by visit is rethrown once the tasks have stopped, chunks not started
+// by then are skipped.
+template<PositionInputs Inputs, typename Visit>
+void for_each_position(ThreadPool& pool, const Inputs& inputs, Visit&& visit) {
+	const usize count = std::ranges::size(inputs);
+	std::vector<std::unique_ptr<Position>> positions(pool.size());
+	parallel_for(pool, (count + parallel::CHUNK_SIZE - 1) / parallel::CHUNK_SIZE, [&](usize chunk) {
+		std::unique_ptr<Position>& p = positions[pool.thread_index()];
+		if (!p) p = std::make_unique<Position>();
+		const usize end = std::min(count, (chunk + 1) * parallel::CHUNK_SIZE);
+		for (usize i = chunk * parallel::CHUNK_SIZE; i < end; i++) {
+			load_position(*p, std::ranges::begin(inputs)[i]);
+			visit(*p, i);
+		}
+	});
+}
+
+// Zobrist hash of every input.
+template<PositionInputs Inputs>
+void hash_all(ThreadPool& pool, const Inputs& inputs, std::span<ZobristHash> hashes) {
+	if (hashes.size() < std::ranges::size(inputs)) throw std::invalid_argument("Output buffer is too small. ");
+	for_each_position(pool, inputs, [&](Position& p, usize i) { hashes[i] = p.hash(); });
+}
+
+// Legal moves of every input into the matching entry of move_lists, as with generate_batch.
+template<MoveGenerationType move_gen_type = ALL, PositionInputs Inputs>
+void generate_all(ThreadPool& pool, const Inputs& inputs, std::span<Stack<Move, MAX_MOVES>> move_lists) {
+	if (move_lists.size() < std::ranges::size(inputs)) throw std::invalid_argument("Output buffer is too small. ");
+	for_each_position(pool, inputs, [&](Position& p, usize i) {
+		Stack<Move, MAX_MOVES>& list = move_lists[i];
+		list.clear();
+		auto push = [&list](Move move) { list.push(move); };
+		if (p.turn() == WHITE) generate<WHITE, move_gen_type>(p, push);
+		else generate<BLACK, move_gen_type>(p, push);
+	});
+}
+
+// Perft node count of every input to the same depth.
+template<PositionInputs Inputs>
+void perft_all(ThreadPool& pool, const Inputs& inputs, i32 depth, std::span<u64> nodes) {
+	if (nodes.size() < std::ranges::size(inputs)) throw std::invalid_argument("Output buffer is too small. ");
+	for_each_position(pool, inputs, [&](Position& p, usize i) {
+		nodes[i] = p.turn() == WHITE ? perft<WHITE>(p, depth) : perft<BLACK>(p, depth);
+	});
+}
+
+namespace parallel {
+	// A position split_ply plies below the root of parallel_divide, and the index of the root move above it.
+	struct Subtree {
+		PackedPosition position;
+		u32 root_move;
+	};
+
+	template<Color Us>
+	void collect_subtrees(Position& p, i32 plies, u32 root_move, std::vector<Subtree>& subtrees) {
+		if (plies == 0) {
+			subtrees.push_back({PackedPosition(p), root_move});
+			return;
+		}
+		for (Move move : MoveList<Us, ALL>(p)) {
+			p.play<Us>(move);
+			collect_subtrees<~Us>(p, plies - 1, root_move, subtrees);
+			p.undo<Us>(move);
+		}
+	}
+}
+
+// Perft below every legal move of p, in the order of MoveList, on the threads of the pool, for depth 1 and more. The
+// positions depth - split_depth plies below p (one ply when depth is smaller) are collected first and the perft of
+// each is a task, so threads are not left idle behind a few large root moves. Subtrees of 3 or 4 plies take tens of
+// microseconds to milliseconds, far more than a task costs. There is a task per position at the split ply, about
+// 200000 at the fourth ply of the start position, so the split ply should stay small.
+template<Color Us>
+std::vector<u64> parallel_divide(ThreadPool& pool, Position& p, i32 depth, i32 split_depth = 3) {
+	const i32 split_ply = std::max(depth - split_depth, 1);
+	std::vector<parallel::Subtree> subtrees;
+	u32 root_moves = 0;
+	for (Move move : MoveList<Us, ALL>(p)) {
+		p.play<Us>(move);
+		parallel::collect_subtrees<~Us>(p, split_ply - 1, root_moves++, subtrees);
+		p.undo<Us>(move);
+	}
+
+	// Each subtree is loaded into the position of the thread running it, tasks do not wait so none is interrupted.
+	std::vector<u64> subtree_nodes(subtrees.size());
+	parallel_for(pool, subtrees.size(), [&](usize i) {
+		thread_local Position position;
+		position.set_packed(subtrees[i].position);
+		subtree_nodes[i] = position.turn() == WHITE ? perft<WHITE>(position, depth - split_ply) :
+						   perft<BLACK>(position, depth - split_ply);
+	});
+
+	std::vector<u64> nodes(root_moves);
+	for (usize i = 0; i < subtrees.size(); i++) nodes[subtrees[i].root_move] += subtree_nodes[i];
+	return nodes;
+}
+
+MIDNIGHT_NAMESPACE_END
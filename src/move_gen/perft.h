@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <ostream>
+#include <vector>
+#include "../board/position.h"
+#include "move_generator.h"
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// Number of leaf nodes depth plies below p, the last ply counted from the size of the move list.
+template<Color Us>
+u64 perft(Position& p, i32 depth) {
+	if (depth == 0) return 1;
+	MoveList<Us, ALL> list(p);
+	if (depth == 1) return list.size();
+	u64 nodes = 0;
+	for (Move move : list) {
+		p.play<Us>(move);
+		nodes += perft<~Us>(p, depth - 1);
+		p.undo<Us>(move);
+	}
+	return nodes;
+}
+
+// Leaf node counters of the standard perft tables, see https://www.chessprogramming.org/Perft_Results.
+// A discovered check is a single check given by a piece other than the one that moved (or the castled rook),
+// double checks are only counted as double checks, as in the published tables.
+struct PerftStats {
+	u64 nodes = 0;
+	u64 captures = 0;
+	u64 en_passants = 0;
+	u64 castles = 0;
+	u64 promotions = 0;
+	u64 checks = 0;
+	u64 discovered_checks = 0;
+	u64 double_checks = 0;
+	u64 checkmates = 0;
+
+	PerftStats& operator+=(const PerftStats& other) {
+		nodes += other.nodes;
+		captures += other.captures;
+		en_passants += other.en_passants;
+		castles += other.castles;
+		promotions += other.promotions;
+		checks += other.checks;
+		discovered_checks += other.discovered_checks;
+		double_checks += other.double_checks;
+		checkmates += other.checkmates;
+		return *this;
+	}
+
+	bool operator==(const PerftStats& other) const = default;
+};
+
+// Same order as the columns of tests/perft_stats.txt.
+inline std::ostream& operator<<(std::ostream& os, const PerftStats& stats) {
+	os << stats.nodes << " " << stats.captures << " " << stats.en_passants << " " << stats.castles << " "
+	   << stats.promotions << " " << stats.checks << " " << stats.discovered_checks << " "
+	   << stats.double_checks << " " << stats.checkmates;
+	return os;
+}
+
+template<Color Us>
+void count_leaf(Position& p, Move move, PerftStats& stats) {
+	stats.nodes++;
+	stats.captures += move.is_capture();
+	stats.en_passants += move.type() == ENPASSANT;
+	stats.castles += move.type() == OO || move.type() == OOO;
+	stats.promotions += move.is_promotion();
+
+	// Move types give the counters above for free, checks need the move to be played.
+	p.play<Us>(move);
+	const Bitboard checkers = p.attackers_of<Us>(lsb(p.occupancy<~Us, KING>()), p.occupancy());
+	if (checkers) {
+		Bitboard moved = square_to_bitboard(move.to());
+		if (move.type() == OO) moved |= square_to_bitboard(Us == WHITE ? f1 : f8);
+		else if (move.type() == OOO) moved |= square_to_bitboard(Us == WHITE ? d1 : d8);
+
+		const bool double_check = checkers & (checkers - 1);
+		stats.checks++;
+		stats.discovered_checks += !double_check && (checkers & ~moved);
+		stats.double_checks += double_check;
+		stats.checkmates += !has_any_legal_move<~Us>(p);
+	}
+	p.undo<Us>(move);
+}
+
+// Collects PerftStats over the leaf nodes depth plies below p.
+template<Color Us>
+void perft_stats(Position& p, i32 depth, PerftStats& stats) {
+	if (depth == 0) {
+		stats.nodes++;
+		return;
+	}
+	for (Move move : MoveList<Us, ALL>(p)) {
+		if (depth == 1) {
+			count_leaf<Us>(p, move, stats);
+			continue;
+		}
+		p.play<Us>(move);
+		perft_stats<~Us>(p, depth - 1, stats);
+		p.undo<Us>(move);
+	}
+}
+
+// Distributions over the nodes at one ply from the root, each indexed by the value and counting nodes.
+struct PlyHistogram {
+	std::array<u64, MAX_MOVES + 1> moves{};
+	// 0, 1 or 2 checkers, for the fraction of nodes in check and in double check.
+	std::array<u64, 3> checkers{};
+	std::array<u64, 9> pinned{};
+	// 0 without an en passant square, 1 with one but no legal en passant capture, 2 with a legal capture.
+	std::array<u64, 3> en_passant{};
+
+	[[nodiscard]] u64 nodes() const {
+		u64 total = 0;
+		for (u64 count : checkers) total += count;
+		return total;
+	}
+
+	PlyHistogram& operator+=(const PlyHistogram& other) {
+		for (usize i = 0; i < moves.size(); i++) moves[i] += other.moves[i];
+		for (usize i = 0; i < checkers.size(); i++) checkers[i] += other.checkers[i];
+		for (usize i = 0; i < pinned.size(); i++) pinned[i] += other.pinned[i];
+		for (usize i = 0; i < en_passant.size(); i++) en_passant[i] += other.en_passant[i];
+		return *this;
+	}
+};
+
+// One histogram per ply of the nodes where moves are generated, leaves are only counted.
+struct PerftHistograms {
+	std::vector<PlyHistogram> plies;
+
+	explicit PerftHistograms(i32 depth = 0) : plies(depth) {}
+
+	PerftHistograms& operator+=(const PerftHistograms& other) {
+		if (plies.size() < other.plies.size()) plies.resize(other.plies.size());
+		for (usize i = 0; i < other.plies.size(); i++) plies[i] += other.plies[i];
+		return *this;
+	}
+};
+
+// Bulk perft that also fills the histograms. The checkers and pins come from the GenerationContext the
+// move list is generated from, so the only extra work per node is a few counter increments.
+template<Color Us>
+u64 perft_histograms(Position& p, i32 depth, PerftHistograms& histograms, i32 ply = 0) {
+	if (depth == 0) return 1;
+	const GenerationContext<Us> context(p);
+	MoveList<Us, ALL> list(p, context);
+
+	PlyHistogram& histogram = histograms.plies[ply];
+	histogram.moves[list.size()]++;
+	histogram.checkers[pop_count(context.masks.checkers)]++;
+	histogram.pinned[pop_count(context.masks.pinned)]++;
+	if (p.ep_square() == NO_SQUARE) histogram.en_passant[0]++;
+	else histogram.en_passant[std::any_of(list.begin(), list.end(), [](Move m) { return m.type() == ENPASSANT; }) ? 2 : 1]++;
+
+	if (depth == 1) return list.size();
+	u64 nodes = 0;
+	for (Move move : list) {
+		p.play<Us>(move);
+		nodes += perft_histograms<~Us>(p, depth - 1, histograms, ply + 1);
+		p.undo<Us>(move);
+	}
+	return nodes;
+}
+
+MIDNIGHT_NAMESPACE_END
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+#include "../types.h"
+
+#if defined(MIDNIGHT_MOVEGEN_PROFILE_CYCLES) && !defined(MIDNIGHT_MOVEGEN_PROFILE)
+#define MIDNIGHT_MOVEGEN_PROFILE
+#endif
+
+#if defined(MIDNIGHT_MOVEGEN_PROFILE_CYCLES) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// Per phase instrumentation of the move generator, enabled by building with MIDNIGHT_MOVEGEN_PROFILE.
+// Every phase counts its calls and the moves it generated, MIDNIGHT_MOVEGEN_PROFILE_CYCLES also times them.
+// Without the flags the scopes are empty types and generation compiles to the same code as before.
+#ifdef MIDNIGHT_MOVEGEN_PROFILE
+constexpr bool MOVEGEN_PROFILE = true;
+#else
+constexpr bool MOVEGEN_PROFILE = false;
+#endif
+
+#ifdef MIDNIGHT_MOVEGEN_PROFILE_CYCLES
+constexpr bool MOVEGEN_PROFILE_CYCLES = true;
+#else
+constexpr bool MOVEGEN_PROFILE_CYCLES = false;
+#endif
+
+enum GeneratorPhase : u8 {
+	// Whole generation calls, the other phases run inside them.
+	PHASE_GENERATE,
+	PHASE_DANGER,
+	PHASE_CHECKERS_AND_PINNED,
+	PHASE_EVASIONS,
+	PHASE_CHECK_CAPTURES,
+	PHASE_EN_PASSANT,
+	PHASE_CASTLE,
+	PHASE_PINNED,
+	PHASE_PIECES,
+	PHASE_PAWNS,
+	PHASE_PROMOTIONS,
+	NPHASES
+};
+
+namespace profile {
+	constexpr std::array<const char*, NPHASES> PHASE_NAMES = {
+		"generate", "danger", "checkers-and-pinned", "evasions", "check-captures", "en-passant", "castle",
+		"pinned", "pieces", "pawns", "promotions"
+	};
+
+#if defined(__x86_64__) || defined(__i386__)
+	constexpr bool TIMESTAMP_COUNTER = true;
+#else
+	constexpr bool TIMESTAMP_COUNTER = false;
+#endif
+
+	// Time stamp counter cycles on x86, nanoseconds elsewhere.
+	inline u64 timestamp() {
+#if defined(MIDNIGHT_MOVEGEN_PROFILE_CYCLES) && (defined(__x86_64__) || defined(__i386__))
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	struct PhaseCounters {
+		std::array<u64, NPHASES> calls{};
+		std::array<u64, NPHASES> moves{};
+		std::array<u64, NPHASES> cycles{};
+
+		PhaseCounters& operator+=(const PhaseCounters& other) {
+			for (usize i = 0; i < NPHASES; i++) {
+				calls[i] += other.calls[i];
+				moves[i] += other.moves[i];
+				cycles[i] += other.cycles[i];
+			}
+			return *this;
+		}
+	};
+
+	struct ThreadCounters;
+
+	// Counters of threads that have exited, and the counters of the threads that are running.
+	inline std::mutex totals_mutex;
+	inline PhaseCounters totals;
+	inline std::vector<ThreadCounters*> live_counters;
+
+	// Each thread counts without synchronization. Its counters are registered while it runs, so they can be collected
+	// from threads that stay alive, such as the workers of a thread pool, and added to the totals when it exits.
+	struct ThreadCounters {
+		PhaseCounters counters;
+		// Moves are attributed to the innermost running phase.
+		GeneratorPhase phase = PHASE_GENERATE;
+
+		ThreadCounters() {
+			std::lock_guard<std::mutex> lock(totals_mutex);
+			live_counters.push_back(this);
+		}
+
+		ThreadCounters(const ThreadCounters&) = delete;
+		ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+		~ThreadCounters() {
+			std::lock_guard<std::mutex> lock(totals_mutex);
+			totals += counters;
+			std::erase(live_counters, this);
+		}
+	};
+
+	inline thread_local ThreadCounters thread_counters;
+
+	inline void count_moves(u64 moves) {
+		thread_counters.counters.moves[thread_counters.phase] += moves;
+	}
+
+	class ActivePhaseScope {
+	private:
+		GeneratorPhase phase_;
+		GeneratorPhase outer_phase_;
+		u64 start_ = 0;
+	public:
+		explicit ActivePhaseScope(GeneratorPhase phase) : phase_(phase), outer_phase_(thread_counters.phase) {
+			thread_counters.phase = phase;
+			thread_counters.counters.calls[phase]++;
+			if constexpr (MOVEGEN_PROFILE_CYCLES) start_ = timestamp();
+		}
+
+		ActivePhaseScope(const ActivePhaseScope&) = delete;
+		ActivePhaseScope& operator=(const ActivePhaseScope&) = delete;
+
+		~ActivePhaseScope() {
+			if constexpr (MOVEGEN_PROFILE_CYCLES) thread_counters.counters.cycles[phase_] += timestamp() - start_;
+			thread_counters.phase = outer_phase_;
+		}
+	};
+
+	struct InactivePhaseScope {
+		constexpr explicit InactivePhaseScope(GeneratorPhase) {}
+	};
+
+	// Declared at the top of each phase: [[maybe_unused]] const profile::PhaseScope scope(PHASE_DANGER);
+	using PhaseScope = std::conditional_t<MOVEGEN_PROFILE, ActivePhaseScope, InactivePhaseScope>;
+
+	// Counters of all threads, running or exited. Running threads must not be generating moves, e.g. their work has
+	// been waited for.
+	inline PhaseCounters collect() {
+		// Registers the calling thread before the lock is taken.
+		[[maybe_unused]] const ThreadCounters& self = thread_counters;
+		std::lock_guard<std::mutex> lock(totals_mutex);
+		PhaseCounters all = totals;
+		for (const ThreadCounters* live : live_counters) all += live->counters;
+		return all;
+	}
+
+	// Same condition as for collect.
+	inline void reset() {
+		[[maybe_unused]] const ThreadCounters& self = thread_counters;
+		std::lock_guard<std::mutex> lock(totals_mutex);
+		totals = {};
+		for (ThreadCounters* live : live_counters) live->counters = {};
+	}
+
+	// One line per phase: calls, moves, and with cycle timers the time spent and its share of the generate calls.
+	// Danger, checkers and pins computed for a GenerationContext or a batch run outside generate calls.
+	inline void report(std::ostream& os) {
+		if constexpr (!MOVEGEN_PROFILE) {
+			os << "Phase counters disabled, build with MIDNIGHT_MOVEGEN_PROFILE" << std::endl;
+			return;
+		}
+		const PhaseCounters all = collect();
+		const char* unit = TIMESTAMP_COUNTER ? "cycles" : "ns";
+		os << std::left << std::setw(22) << "phase" << std::right << std::setw(14) << "calls" << std::setw(14) << "moves";
+		if constexpr (MOVEGEN_PROFILE_CYCLES) os << std::setw(16) << unit << std::setw(12) << "per call" << std::setw(9) << "share";
+		os << std::endl;
+
+		for (usize i = 0; i < NPHASES; i++) {
+			os << std::left << std::setw(22) << PHASE_NAMES[i] << std::right << std::setw(14) << all.calls[i]
+			   << std::setw(14) << all.moves[i];
+			if constexpr (MOVEGEN_PROFILE_CYCLES) {
+				const double per_call = all.calls[i] ? static_cast<double>(all.cycles[i]) / all.calls[i] : 0;
+				const double share = all.cycles[PHASE_GENERATE] ? 100.0 * all.cycles[i] / all.cycles[PHASE_GENERATE] : 0;
+				os << std::setw(16) << all.cycles[i] << std::fixed << std::setprecision(1) << std::setw(12) << per_call
+				   << std::setw(8) << share << "%";
+			}
+			os << std::endl;
+		}
+	}
+}
+
+MIDNIGHT_NAMESPACE_END
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include "../types.h"
+#include "../board/position.h"
+#include "types/move.h"
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// A deliberately naive legal move generator to test the fast one against. It walks file and rank offsets over the
+// board array instead of using bitboards or attack tables, generates pseudo-legal moves, and keeps the moves that
+// do not leave the king attacked after playing them. Only Position::play, undo and the castling rights are shared.
+namespace reference {
+	struct Offset {
+		i32 file, rank;
+	};
+
+	constexpr std::array<Offset, 8> KNIGHT_OFFSETS = {{{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}}};
+	constexpr std::array<Offset, 8> KING_OFFSETS = {{{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}}};
+	constexpr std::array<Offset, 4> ROOK_DIRECTIONS = {{{1, 0}, {0, 1}, {-1, 0}, {0, -1}}};
+	constexpr std::array<Offset, 4> BISHOP_DIRECTIONS = {{{1, 1}, {-1, 1}, {-1, -1}, {1, -1}}};
+	constexpr std::array<MoveType, 4> PROMOTIONS = {PR_KNIGHT, PR_BISHOP, PR_ROOK, PR_QUEEN};
+
+	inline bool on_board(i32 file, i32 rank) { return file >= 0 && file < 8 && rank >= 0 && rank < 8; }
+
+	inline Square square_at(i32 file, i32 rank) { return create_square(File(file), Rank(rank)); }
+
+	inline bool is_piece(const Position& p, i32 file, i32 rank, Color color, PieceType type) {
+		const Piece piece = p.piece_at(square_at(file, rank));
+		return piece != NO_PIECE && color_of(piece) == color && type_of(piece) == type;
+	}
+
+	// Whether a piece of color `by` attacks s, found by looking outwards from s.
+	inline bool attacked(const Position& p, Square s, Color by) {
+		const i32 file = file_of(s), rank = rank_of(s);
+
+		// Pawns of `by` attack s from one rank behind s, seen from `by`.
+		const i32 pawn_rank = rank - (by == WHITE ? 1 : -1);
+		for (i32 df : {-1, 1}) {
+			if (on_board(file + df, pawn_rank) && is_piece(p, file + df, pawn_rank, by, PAWN)) return true;
+		}
+		for (Offset o : KNIGHT_OFFSETS) {
+			if (on_board(file + o.file, rank + o.rank) && is_piece(p, file + o.file, rank + o.rank, by, KNIGHT)) return true;
+		}
+		for (Offset o : KING_OFFSETS) {
+			if (on_board(file + o.file, rank + o.rank) && is_piece(p, file + o.file, rank + o.rank, by, KING)) return true;
+		}
+
+		auto slider_attacks = [&](const std::array<Offset, 4>& directions, PieceType slider) {
+			for (Offset d : directions) {
+				for (i32 f = file + d.file, r = rank + d.rank; on_board(f, r); f += d.file, r += d.rank) {
+					const Piece piece = p.piece_at(square_at(f, r));
+					if (piece == NO_PIECE) continue;
+					if (color_of(piece) == by && (type_of(piece) == slider || type_of(piece) == QUEEN)) return true;
+					break;
+				}
+			}
+			return false;
+		};
+		return slider_attacks(ROOK_DIRECTIONS, ROOK) || slider_attacks(BISHOP_DIRECTIONS, BISHOP);
+	}
+
+	inline Square king_square(const Position& p, Color color) {
+		for (Square s = a1; s < NSQUARES; s++) {
+			const Piece piece = p.piece_at(s);
+			if (piece != NO_PIECE && color_of(piece) == color && type_of(piece) == KING) return s;
+		}
+		return NO_SQUARE;
+	}
+
+	template<Color Us>
+	void pseudo_legal_pawn_moves(const Position& p, Square from, std::vector<Move>& moves) {
+		const i32 forward = Us == WHITE ? 1 : -1;
+		const i32 file = file_of(from), rank = rank_of(from);
+		const i32 promotion_rank = Us == WHITE ? 7 : 0;
+		const i32 start_rank = Us == WHITE ? 1 : 6;
+
+		auto add = [&](Square to, MoveType type) {
+			if (rank_of(to) != promotion_rank) moves.emplace_back(from, to, type);
+			else for (MoveType promotion : PROMOTIONS) moves.emplace_back(from, to, type | promotion);
+		};
+
+		const Square one = square_at(file, rank + forward);
+		if (p.piece_at(one) == NO_PIECE) {
+			add(one, QUIET);
+			if (rank == start_rank && p.piece_at(square_at(file, rank + 2 * forward)) == NO_PIECE) {
+				moves.emplace_back(from, square_at(file, rank + 2 * forward), DOUBLE_PUSH);
+			}
+		}
+
+		for (i32 df : {-1, 1}) {
+			if (!on_board(file + df, rank + forward)) continue;
+			const Square to = square_at(file + df, rank + forward);
+			const Piece target = p.piece_at(to);
+			if (target != NO_PIECE && color_of(target) != Us) add(to, CAPTURE_TYPE);
+			else if (target == NO_PIECE && to == p.ep_square()) moves.emplace_back(from, to, ENPASSANT);
+		}
+	}
+
+	template<Color Us>
+	void pseudo_legal_castles(const Position& p, std::vector<Move>& moves) {
+		const i32 rank = Us == WHITE ? 0 : 7;
+		if (attacked(p, square_at(4, rank), ~Us)) return;
+
+		auto empty = [&](std::initializer_list<i32> files) {
+			return std::all_of(files.begin(), files.end(), [&](i32 f) { return p.piece_at(square_at(f, rank)) == NO_PIECE; });
+		};
+		auto safe = [&](std::initializer_list<i32> files) {
+			return std::none_of(files.begin(), files.end(), [&](i32 f) { return attacked(p, square_at(f, rank), ~Us); });
+		};
+
+		// The king may not cross an attacked square, the landing square is checked with the other moves.
+		if (p.king_and_oo_rook_not_moved<Us>() && empty({5, 6}) && safe({5})) {
+			moves.emplace_back(square_at(4, rank), square_at(6, rank), OO);
+		}
+		if (p.king_and_ooo_rook_not_moved<Us>() && empty({1, 2, 3}) && safe({3})) {
+			moves.emplace_back(square_at(4, rank), square_at(2, rank), OOO);
+		}
+	}
+
+	template<Color Us>
+	std::vector<Move> pseudo_legal_moves(const Position& p) {
+		std::vector<Move> moves;
+		for (Square from = a1; from < NSQUARES; from++) {
+			const Piece piece = p.piece_at(from);
+			if (piece == NO_PIECE || color_of(piece) != Us) continue;
+
+			auto add_target = [&](i32 file, i32 rank) {
+				const Piece target = p.piece_at(square_at(file, rank));
+				if (target == NO_PIECE) moves.emplace_back(from, square_at(file, rank), QUIET);
+				else if (color_of(target) != Us) moves.emplace_back(from, square_at(file, rank), CAPTURE_TYPE);
+				return target == NO_PIECE;
+			};
+			auto add_steps = [&](const std::array<Offset, 8>& offsets) {
+				for (Offset o : offsets) {
+					if (on_board(file_of(from) + o.file, rank_of(from) + o.rank)) add_target(file_of(from) + o.file, rank_of(from) + o.rank);
+				}
+			};
+			auto add_slides = [&](const std::array<Offset, 4>& directions) {
+				for (Offset d : directions) {
+					for (i32 f = file_of(from) + d.file, r = rank_of(from) + d.rank; on_board(f, r); f += d.file, r += d.rank) {
+						if (!add_target(f, r)) break;
+					}
+				}
+			};
+
+			switch (type_of(piece)) {
+				case PAWN: pseudo_legal_pawn_moves<Us>(p, from, moves); break;
+				case KNIGHT: add_steps(KNIGHT_OFFSETS); break;
+				case BISHOP: add_slides(BISHOP_DIRECTIONS); break;
+				case ROOK: add_slides(ROOK_DIRECTIONS); break;
+				case QUEEN: add_slides(ROOK_DIRECTIONS); add_slides(BISHOP_DIRECTIONS); break;
+				case KING: add_steps(KING_OFFSETS); break;
+				default: break;
+			}
+		}
+		pseudo_legal_castles<Us>(p, moves);
+		return moves;
+	}
+
+	// All legal moves of the side to move, in no particular order.
+	template<Color Us>
+	std::vector<Move> legal_moves(Position& p) {
+		std::vector<Move> legal;
+		for (Move move : pseudo_legal_moves<Us>(p)) {
+			p.play<Us>(move);
+			if (!attacked(p, king_square(p, Us), ~Us)) legal.push_back(move);
+			p.undo<Us>(move);
+		}
+		return legal;
+	}
+
+	inline std::vector<Move> legal_moves(Position& p) {
+		return p.turn() == WHITE ? legal_moves<WHITE>(p) : legal_moves<BLACK>(p);
+	}
+}
+
+MIDNIGHT_NAMESPACE_END
@@ -1,11 +1,31 @@
 #pragma once
-#pragma once
 
 #include "../types/types.h"
 #include "../../board/types/bitboard.h"
 #include "../../board/types/piece.h"
 #include "../../../tests/lib/doctests.h"
 #include "../../board/constants/zobrist_constants.h"
+#include "../setwise_attacks.h"
+#include "../../utils/huge_pages.h"
+#include <atomic>
+#include <mutex>
+
+#ifdef MIDNIGHT_NUMA_TABLES
+#include "../../utils/numa.h"
+#endif
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// Huge page backed and per node tables are allocated at startup, so they are always computed at runtime.
+#if (defined(MIDNIGHT_HUGE_PAGE_TABLES) || defined(MIDNIGHT_NUMA_TABLES)) && !defined(MIDNIGHT_RUNTIME_TABLES)
+#define MIDNIGHT_RUNTIME_TABLES
+#endif
+
+// Every level of a multi ISA build runs its static initializers at startup, before the dispatch, so filling the
+// tables there would run instructions of the newest level on any CPU.
+#if defined(MIDNIGHT_ISA_NAMESPACE) && defined(MIDNIGHT_RUNTIME_TABLES)
+#error "Multi ISA builds need compile time tables"
+#endif
 
 namespace tables {
 	namespace {
@@ -160,15 +180,15 @@ namespace tables {
 			return 0;
 		}
 
-		[[nodiscard]] consteval Bitboard empty_board_rook_attacks(Square square) {
+		[[nodiscard]] constexpr Bitboard empty_board_rook_attacks(Square square) {
 			return MASK_RANK[rank_of(square)] ^ MASK_FILE[file_of(square)];
 		}
 
-		[[nodiscard]] consteval Bitboard empty_board_bishop_attacks(Square square) {
+		[[nodiscard]] constexpr Bitboard empty_board_bishop_attacks(Square square) {
 			return MASK_DIAGONAL[diagonal_of(square)] ^ MASK_ANTI_DIAGONAL[anti_diagonal_of(square)];
 		}
 
-		[[nodiscard]] consteval array<Bitboard, NSQUARES> generate_rook_attack_masks() {
+		[[nodiscard]] constexpr array<Bitboard, NSQUARES> generate_rook_attack_masks() {
 			array<Bitboard, NSQUARES> rook_attack_masks{};
 			for (Square sq = a1; sq < NSQUARES; sq++) {
 				Bitboard edges = 	((board_edge(NORTH) | board_edge(SOUTH)) & ~MASK_RANK[rank_of(sq)]) |
@@ -178,7 +198,7 @@ namespace tables {
 			return rook_attack_masks;
 		}
 
-		[[nodiscard]] consteval array<Bitboard, NSQUARES> generate_bishop_attack_masks() {
+		[[nodiscard]] constexpr array<Bitboard, NSQUARES> generate_bishop_attack_masks() {
 			array<Bitboard, NSQUARES> bishop_attack_masks{};
 			for (Square sq = a1; sq < NSQUARES; sq++) {
 				Bitboard edges = board_edge(NORTH) | board_edge(SOUTH) | board_edge(EAST) | board_edge(WEST);
@@ -190,7 +210,7 @@ namespace tables {
 		constexpr array<Bitboard, NSQUARES> rook_attack_masks = generate_rook_attack_masks();
 		constexpr array<Bitboard, NSQUARES> bishop_attack_masks = generate_bishop_attack_masks();
 
-		[[nodiscard]] consteval Bitboard generate_slow_sliding_attacks(Square sq, Direction direction, Bitboard occupancy) {
+		[[nodiscard]] constexpr Bitboard generate_slow_sliding_attacks(Square sq, Direction direction, Bitboard occupancy) {
 			Bitboard attacks{};
 
 			Bitboard blockers = board_edge(direction);
@@ -208,14 +228,14 @@ namespace tables {
 			return attacks;
 		}
 
-		[[nodiscard]] consteval Bitboard generate_slow_rook_attacks(Square sq, Bitboard occupancy) {
+		[[nodiscard]] constexpr Bitboard generate_slow_rook_attacks(Square sq, Bitboard occupancy) {
 			return generate_slow_sliding_attacks(sq, NORTH, occupancy) |
 				   generate_slow_sliding_attacks(sq, SOUTH, occupancy) |
 				   generate_slow_sliding_attacks(sq, EAST, occupancy) |
 				   generate_slow_sliding_attacks(sq, WEST, occupancy);
 		}
 
-		[[nodiscard]] consteval Bitboard generate_slow_bishop_attacks(Square sq, Bitboard occupancy) {
+		[[nodiscard]] constexpr Bitboard generate_slow_bishop_attacks(Square sq, Bitboard occupancy) {
 			return generate_slow_sliding_attacks(sq, NORTH_EAST, occupancy) |
 				   generate_slow_sliding_attacks(sq, NORTH_WEST, occupancy) |
 				   generate_slow_sliding_attacks(sq, SOUTH_EAST, occupancy) |
@@ -223,7 +243,7 @@ namespace tables {
 		}
 
 
-		[[nodiscard]] consteval array<array<Bitboard, ROOK_TABLE_SIZE>, NSQUARES> generate_rook_attack_table() {
+		[[nodiscard]] constexpr array<array<Bitboard, ROOK_TABLE_SIZE>, NSQUARES> generate_rook_attack_table() {
 			array<array<Bitboard, ROOK_TABLE_SIZE>, NSQUARES> rook_attack_table{};
 			Bitboard subset{}, index{};
 
@@ -240,7 +260,7 @@ namespace tables {
 			return rook_attack_table;
 		}
 
-		[[nodiscard]] consteval array<array<Bitboard, BISHOP_TABLE_SIZE>, NSQUARES> generate_bishop_attack_table() {
+		[[nodiscard]] constexpr array<array<Bitboard, BISHOP_TABLE_SIZE>, NSQUARES> generate_bishop_attack_table() {
 			array<array<Bitboard, BISHOP_TABLE_SIZE>, NSQUARES> bishop_attack_table{};
 			Bitboard subset{}, index{};
 
@@ -257,20 +277,129 @@ namespace tables {
 			return bishop_attack_table;
 		}
 
+#ifndef MIDNIGHT_RUNTIME_TABLES
 		constexpr array<array<Bitboard, ROOK_TABLE_SIZE>, NSQUARES> rook_attack_table = generate_rook_attack_table();
+		constexpr array<array<Bitboard, BISHOP_TABLE_SIZE>, NSQUARES> bishop_attack_table = generate_bishop_attack_table();
+#endif
+	} // anon namespace
+
+#ifdef MIDNIGHT_RUNTIME_TABLES
+	// The large tables, filled at startup instead of by the compiler. Computing them at compile time needs
+	// a raised constexpr limit, is slow for every translation unit and stores them in the binary.
+	struct alignas(CACHE_LINE_SIZE) TableBlock {
+		array<array<Bitboard, ROOK_TABLE_SIZE>, NSQUARES> rook_attack_table;
+		array<array<Bitboard, BISHOP_TABLE_SIZE>, NSQUARES> bishop_attack_table;
+		array<array<Bitboard, NSQUARES>, NSQUARES> squares_in_between;
+		array<array<Bitboard, NSQUARES>, NSQUARES> square_line;
+	};
+
+#ifdef MIDNIGHT_HUGE_PAGE_TABLES
+	// One huge page aligned allocation, so every lookup is covered by two 2MiB TLB entries instead of ~600 4KiB ones.
+	inline TableBlock& table_block = *new (allocate_huge_pages(sizeof(TableBlock))) TableBlock{};
+#else
+	inline TableBlock table_block;
+#endif
+
+	// Slider attacks come from vectorized setwise fills instead of walking each ray, about half a millisecond in total.
+	inline void initialize_tables() {
+		for (Square sq = a1; sq < NSQUARES; sq++) {
+			const Bitboard from = square_to_bitboard(sq);
+
+			Bitboard subset = 0;
+			do {
+				table_block.rook_attack_table[sq][(subset * ROOK_MAGICS[sq]) >> ROOK_SHIFTS[sq]] = setwise::slider_attacks(from, 0, ~subset);
+				subset = (subset - rook_attack_masks[sq]) & rook_attack_masks[sq];
+			} while (subset);
+
+			subset = 0;
+			do {
+				table_block.bishop_attack_table[sq][(subset * BISHOP_MAGICS[sq]) >> BISHOP_SHIFTS[sq]] = setwise::slider_attacks(0, from, ~subset);
+				subset = (subset - bishop_attack_masks[sq]) & bishop_attack_masks[sq];
+			} while (subset);
+
+			for (Square sq2 = a1; sq2 < NSQUARES; sq2++) {
+				const Bitboard to = square_to_bitboard(sq2);
+				const Bitboard empty = ~(from | to);
+				Bitboard in_between = 0, line = 0;
+
+				if (file_of(sq) == file_of(sq2) || rank_of(sq) == rank_of(sq2)) {
+					in_between = setwise::rook_attacks(from, empty) & setwise::rook_attacks(to, empty);
+					line = setwise::rook_attacks(from, ~0ULL) & setwise::rook_attacks(to, ~0ULL);
+				} else if (diagonal_of(sq) == diagonal_of(sq2) || anti_diagonal_of(sq) == anti_diagonal_of(sq2)) {
+					in_between = setwise::bishop_attacks(from, empty) & setwise::bishop_attacks(to, empty);
+					line = setwise::bishop_attacks(from, ~0ULL) & setwise::bishop_attacks(to, ~0ULL);
+				}
+				table_block.squares_in_between[sq][sq2] = in_between;
+				table_block.square_line[sq][sq2] = line;
+			}
+		}
+	}
+
+	// Initialized before any global defined after this header is included, in every translation unit.
+	inline const bool tables_initialized = (initialize_tables(), true);
+
+#ifdef MIDNIGHT_NUMA_TABLES
+	// Copies of the table block, one per NUMA node, created by the first thread bound on each node.
+	inline array<std::atomic<TableBlock*>, MAX_NUMA_NODES> numa_table_blocks{};
+	inline std::mutex numa_table_blocks_mutex;
+
+	// Tables of the calling thread. Threads that never called bind_thread_tables() use the shared table_block.
+	inline constinit thread_local TableBlock* thread_table_block = nullptr;
+
+	// Points the calling thread at the copy of the tables on its NUMA node, creating the copy on first use.
+	// Threads should be pinned to a node before binding, or they may later migrate away from their copy.
+	inline void bind_thread_tables() {
+		const usize node = current_numa_node();
+		TableBlock* block = numa_table_blocks[node].load(std::memory_order_acquire);
+		if (block == nullptr) {
+			std::lock_guard<std::mutex> lock(numa_table_blocks_mutex);
+			block = numa_table_blocks[node].load(std::memory_order_relaxed);
+			if (block == nullptr) {
+#ifdef MIDNIGHT_HUGE_PAGE_TABLES
+				void* memory = allocate_huge_pages(sizeof(TableBlock));
+				place_on_numa_node(memory, sizeof(TableBlock), node);
+#else
+				void* memory = allocate_on_numa_node(sizeof(TableBlock), node);
+#endif
+				// Copied by this thread, so without libnuma the pages are first touched on this node.
+				block = new (memory) TableBlock(table_block);
+				numa_table_blocks[node].store(block, std::memory_order_release);
+			}
+		}
+		thread_table_block = block;
+	}
+#endif
+
+	[[nodiscard]] inline const TableBlock& active_tables() {
+#ifdef MIDNIGHT_NUMA_TABLES
+		if (thread_table_block != nullptr) return *thread_table_block;
+#endif
+		return table_block;
+	}
+#endif
 
+	namespace {
+#ifdef MIDNIGHT_RUNTIME_TABLES
+		inline Bitboard get_rook_attacks(Square square, Bitboard occ) {
+			usize index = ((occ & rook_attack_masks[square]) * ROOK_MAGICS[square]) >> ROOK_SHIFTS[square];
+			return active_tables().rook_attack_table[square][index];
+		}
+
+		inline Bitboard get_bishop_attacks(Square square, Bitboard occ) {
+			usize index = ((occ & bishop_attack_masks[square]) * BISHOP_MAGICS[square]) >> BISHOP_SHIFTS[square];
+			return active_tables().bishop_attack_table[square][index];
+		}
+#else
 		constexpr Bitboard get_rook_attacks(Square square, Bitboard occ) {
 			usize index = ((occ & rook_attack_masks[square]) * ROOK_MAGICS[square]) >> ROOK_SHIFTS[square];
 			return rook_attack_table[square][index];
 		}
 
-		constexpr array<array<Bitboard, BISHOP_TABLE_SIZE>, NSQUARES> bishop_attack_table = generate_bishop_attack_table();
-
 		constexpr Bitboard get_bishop_attacks(Square square, Bitboard occ) {
 			usize index = ((occ & bishop_attack_masks[square]) * BISHOP_MAGICS[square]) >> BISHOP_SHIFTS[square];
 			return bishop_attack_table[square][index];
 		}
-
+#endif
 	} // anon namespace
 
 	template<PieceType piece_type, Color color = WHITE>
@@ -321,4 +450,6 @@ namespace tables {
 	}
 
 	TEST_SUITE_END();
-} // table namespace
\ No newline at end of file
+} // table namespace
+
+MIDNIGHT_NAMESPACE_END
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "../types/types.h"
 #include "../../board/types/bitboard.h"
 #include "../../board/types/piece.h"
@@ -5,9 +7,11 @@
 #include "../../board/constants/zobrist_constants.h"
 #include "attack_tables.h"
 
+MIDNIGHT_NAMESPACE_BEGIN
+
 namespace tables {
 	namespace {
-		consteval array<array<Bitboard, NSQUARES>, NSQUARES> generate_squares_in_between() {
+		constexpr array<array<Bitboard, NSQUARES>, NSQUARES> generate_squares_in_between() {
 			array<array<Bitboard, NSQUARES>, NSQUARES> squares_in_between{};
 			for (Square sq1 = a1; sq1 < NSQUARES; sq1++) {
 				for (Square sq2 = a1; sq2 < NSQUARES; sq2++) {
@@ -22,9 +26,11 @@ namespace tables {
 			}
 			return squares_in_between;
 		}
+#ifndef MIDNIGHT_RUNTIME_TABLES
 		constexpr array<array<Bitboard, NSQUARES>, NSQUARES> squares_in_between = generate_squares_in_between();
+#endif
 
-		consteval array<array<Bitboard, NSQUARES>, NSQUARES> generate_square_line() {
+		constexpr array<array<Bitboard, NSQUARES>, NSQUARES> generate_square_line() {
 			array<array<Bitboard, NSQUARES>, NSQUARES> square_line{};
 			for (Square sq1 = a1; sq1 < NSQUARES; sq1++) {
 				for (Square sq2 = a1; sq2 < NSQUARES; sq2++) {
@@ -38,9 +44,20 @@ namespace tables {
 			}
 			return square_line;
 		}
+#ifndef MIDNIGHT_RUNTIME_TABLES
 		constexpr array<array<Bitboard, NSQUARES>, NSQUARES> square_line = generate_square_line();
+#endif
+	}
+
+#ifdef MIDNIGHT_RUNTIME_TABLES
+	inline Bitboard square_in_between(Square sq1, Square sq2) {
+		return active_tables().squares_in_between[sq1][sq2];
 	}
 
+	inline Bitboard line_of(Square sq1, Square sq2) {
+		return active_tables().square_line[sq1][sq2];
+	}
+#else
 	inline constexpr Bitboard square_in_between(Square sq1, Square sq2) {
 		return squares_in_between[sq1][sq2];
 	}
@@ -48,4 +65,7 @@ namespace tables {
 	inline constexpr Bitboard line_of(Square sq1, Square sq2) {
 		return square_line[sq1][sq2];
 	}
-}
\ No newline at end of file
+#endif
+}
+
+MIDNIGHT_NAMESPACE_END
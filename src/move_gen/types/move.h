@@ -1,9 +1,12 @@
 #pragma once
 #include <cstdint>
+#include <string_view>
 #include "../../types.h"
 #include "../../board/types/board_types.h"
 #include "../../board/types/square.h"
 
+MIDNIGHT_NAMESPACE_BEGIN
+
 using MoveType = u8;
 
 constexpr MoveType QUIET		= 0b0000;
@@ -60,18 +63,62 @@ public:
 	[[nodiscard]] inline bool is_promotion() const { return (move >> TYPE_SHIFT) & PROMOTION_BITMASK; }
 	[[nodiscard]] inline bool is_quiet() const { return !is_capture() && !is_promotion(); }
 
+	[[nodiscard]] constexpr u16 raw() const { return move; }
+
 	bool operator==(Move a) const { return move == a.move; }
 	bool operator!=(Move a) const { return move != a.move; }
 };
 
 constexpr Move EMPTY_MOVE = Move();
 
+using MoveScore = i16;
+
+class ScoredMove {
+private:
+	// Bits are arranged as follows
+	// | 16 bits for biased score | 16 bits for move
+	// The score is biased so that comparing the raw values orders entries by score.
+	u32 entry;
+
+	static constexpr u8 SCORE_SHIFT		= 16;
+	static constexpr u32 MOVE_BITMASK	= 0xFFFF;
+	static constexpr u16 SCORE_BIAS		= 0x8000;
+
+public:
+	constexpr ScoredMove() : entry(0) {}
+
+	// Implicit so the move generator can fill scored lists directly.
+	constexpr ScoredMove(Move m) : entry(static_cast<u32>(SCORE_BIAS) << SCORE_SHIFT | m.raw()) {}
+
+	constexpr ScoredMove(Move m, MoveScore score) : entry(0) {
+		entry = static_cast<u32>(static_cast<u16>(score) ^ SCORE_BIAS) << SCORE_SHIFT | m.raw();
+	}
+
+	[[nodiscard]] constexpr Move move() const { return Move(static_cast<u16>(entry & MOVE_BITMASK)); }
+	[[nodiscard]] constexpr MoveScore score() const { return static_cast<MoveScore>((entry >> SCORE_SHIFT) ^ SCORE_BIAS); }
+	[[nodiscard]] constexpr u32 raw() const { return entry; }
+
+	constexpr void set_score(MoveScore score) { *this = ScoredMove(move(), score); }
+
+	constexpr operator Move() const { return move(); }
+};
+
+static_assert(sizeof(ScoredMove) == 4);
+
 inline array<string , 16> MOVE_TYPE_UCI = {
-		"", "", "", "", "N", "B", "R", "Q",
-		"", "", "", "", "N", "B", "R", "Q"
+		"", "", "", "", "n", "b", "r", "q",
+		"", "", "", "", "n", "b", "r", "q"
 };
 
+// Whether the UCI text, e.g. "e7e8q", names the move. Compares in place, for parsing moves without allocating.
+inline bool matches_uci(Move m, std::string_view uci) {
+	return uci.size() == 4 + MOVE_TYPE_UCI[m.type()].size() && uci.substr(0, 2) == SQ_TO_STRING[m.from()] &&
+			uci.substr(2, 2) == SQ_TO_STRING[m.to()] && uci.substr(4) == MOVE_TYPE_UCI[m.type()];
+}
+
 inline std::ostream& operator<<(std::ostream& os, const Move& m) {
 	os << SQ_TO_STRING[m.from()] << SQ_TO_STRING[m.to()] << MOVE_TYPE_UCI[m.type()];
 	return os;
 }
+
+MIDNIGHT_NAMESPACE_END
@@ -1,8 +1,33 @@
 #pragma once
 
 #include "../../types.h"
+#include "../../board/types/board_types.h"
+#include "../../board/types/piece.h"
+
+MIDNIGHT_NAMESPACE_BEGIN
 
 enum MoveGenerationType : i32 {
 	ALL,
-	CAPTURES
+	CAPTURES,
+	// Stops once a legal move has been found, used for terminal detection.
+	ANY
+};
+
+// Upper bound on the number of legal moves in any position.
+constexpr usize MAX_MOVES = 218;
+
+// Squares attacked by the opponent (with our king removed from the occupancy), pieces giving check,
+// and our pieces pinned to our king.
+struct LegalityMasks {
+	Bitboard danger;
+	Bitboard checkers;
+	Bitboard pinned;
 };
+
+// Restricts generation to moves of pieces standing on `from` whose type is in `piece_types`.
+struct MoveFilter {
+	Bitboard from = ~0ULL;
+	PieceTypeSet piece_types = ALL_PIECE_TYPES;
+};
+
+MIDNIGHT_NAMESPACE_END
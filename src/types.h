@@ -3,6 +3,21 @@
 #include <string>
 #include <array>
 
+// Multi ISA builds compile the library and a program once per instruction set level, each copy in its own inline
+// namespace, so the inline functions and tables of different levels are not merged at link time. The program's
+// MIDNIGHT_MAIN becomes isa_main in that namespace and tools/isa_main.cpp calls the one the CPU supports.
+#ifdef MIDNIGHT_ISA_NAMESPACE
+#define MIDNIGHT_NAMESPACE_BEGIN inline namespace MIDNIGHT_ISA_NAMESPACE {
+#define MIDNIGHT_NAMESPACE_END }
+#define MIDNIGHT_MAIN isa_main
+#else
+#define MIDNIGHT_NAMESPACE_BEGIN
+#define MIDNIGHT_NAMESPACE_END
+#define MIDNIGHT_MAIN main
+#endif
+
+MIDNIGHT_NAMESPACE_BEGIN
+
 using u8 = std::uint8_t;
 using u16 = std::uint16_t;
 using u32 = std::uint32_t;
@@ -19,4 +34,6 @@ using f64 = double;
 using usize = std::size_t;
 
 using std::string;
-using std::array;
\ No newline at end of file
+using std::array;
+
+MIDNIGHT_NAMESPACE_END
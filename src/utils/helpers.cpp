@@ -3,9 +3,12 @@
 //
 
 #include <sstream>
+#include <stdexcept>
 #include <vector>
 #include <algorithm>
-#include "../types.h"
+#include "helpers.h"
+
+MIDNIGHT_NAMESPACE_BEGIN
 
 std::vector<std::string> split(const std::string& s, const std::string& delimiter) {
 	usize pos_start = 0, pos_end, delim_len = delimiter.length();
@@ -21,3 +24,14 @@ std::vector<std::string> split(const std::string& s, const std::string& delimite
 	res.push_back(s.substr (pos_start));
 	return res;
 }
+
+usize parse_thread_count(const std::string& s) {
+	try {
+		const int threads = std::stoi(s);
+		return threads >= 1 && static_cast<usize>(threads) <= MAX_THREADS ? static_cast<usize>(threads) : 0;
+	} catch (const std::exception&) {
+		return 0;
+	}
+}
+
+MIDNIGHT_NAMESPACE_END
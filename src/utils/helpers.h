@@ -7,4 +7,22 @@
 #include <vector>
 #include "../board/constants/misc_constants.h"
 
-std::vector<std::string> split(const std::string& s, const std::string& delimiter);
\ No newline at end of file
+MIDNIGHT_NAMESPACE_BEGIN
+
+std::vector<std::string> split(const std::string& s, const std::string& delimiter);
+
+// Most threads the tools start, larger --threads values are taken for typos.
+constexpr usize MAX_THREADS = 1024;
+
+// Value of a --threads argument, 0 unless it is a number in [1, MAX_THREADS].
+usize parse_thread_count(const std::string& s);
+
+// SplitMix64 (Steele, Lea and Flood), a small seedable generator for reproducible random games.
+inline u64 splitmix64(u64& state) {
+	u64 z = (state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+MIDNIGHT_NAMESPACE_END
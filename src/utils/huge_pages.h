@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "../types.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+constexpr usize CACHE_LINE_SIZE = 64;
+constexpr usize HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Allocates memory aligned to a 2MiB huge page and asks Linux to back it with transparent huge pages,
+// so a large lookup table is covered by a single TLB entry. Elsewhere, or when THP is disabled,
+// this is a plain aligned allocation. The memory is never freed.
+inline void* allocate_huge_pages(usize bytes) {
+	const usize size = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+	void* memory = std::aligned_alloc(HUGE_PAGE_SIZE, size);
+	if (memory == nullptr) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+	madvise(memory, size, MADV_HUGEPAGE);
+#endif
+	return memory;
+}
+
+// Huge pages backing this process's anonymous memory, in KiB, or 0 where that is not reported.
+inline usize anonymous_huge_pages_kib() {
+	usize kib = 0;
+#ifdef __linux__
+	if (FILE* smaps = std::fopen("/proc/self/smaps_rollup", "r")) {
+		char line[256];
+		while (std::fgets(line, sizeof(line), smaps)) {
+			if (std::sscanf(line, "AnonHugePages: %zu kB", &kib) == 1) break;
+		}
+		std::fclose(smaps);
+	}
+#endif
+	return kib;
+}
+
+MIDNIGHT_NAMESPACE_END
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstdlib>
+#include <string_view>
+#include "../types.h"
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// x86-64 micro-architecture levels a multi ISA build is compiled for. v2 adds POPCNT and SSE4.2, v3 AVX2, BMI1/2
+// and LZCNT (single instruction pop_count and lsb, 256 bit batch generation), v4 AVX-512.
+enum IsaLevel : u8 {
+	ISA_X86_64,
+	ISA_X86_64_V2,
+	ISA_X86_64_V3,
+	ISA_X86_64_V4,
+	NISA_LEVELS
+};
+
+constexpr std::array<const char*, NISA_LEVELS> ISA_NAMES = {"x86-64", "x86-64-v2", "x86-64-v3", "x86-64-v4"};
+
+// The highest level the CPU and operating system support, from CPUID.
+inline IsaLevel supported_isa_level() {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+	const bool v2 = __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("sse4.2") &&
+			__builtin_cpu_supports("ssse3");
+	const bool v3 = v2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") &&
+			__builtin_cpu_supports("bmi2") && __builtin_cpu_supports("fma");
+	const bool v4 = v3 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+			__builtin_cpu_supports("avx512cd") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl");
+	if (v4) return ISA_X86_64_V4;
+	if (v3) return ISA_X86_64_V3;
+	if (v2) return ISA_X86_64_V2;
+#endif
+	return ISA_X86_64;
+}
+
+// The supported level, or the lower level named by the MIDNIGHT_ISA environment variable, e.g. to compare levels on
+// one machine. NISA_LEVELS when MIDNIGHT_ISA names an unknown or unsupported level.
+inline IsaLevel selected_isa_level() {
+	const IsaLevel supported = supported_isa_level();
+	const char* requested = std::getenv("MIDNIGHT_ISA");
+	if (!requested || !*requested) return supported;
+	for (usize level = 0; level <= supported; level++) {
+		if (std::string_view(requested) == ISA_NAMES[level]) return static_cast<IsaLevel>(level);
+	}
+	return NISA_LEVELS;
+}
+
+MIDNIGHT_NAMESPACE_END
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include "../types.h"
+
+#ifdef MIDNIGHT_LIBNUMA
+#include <numa.h>
+#endif
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+constexpr usize MAX_NUMA_NODES = 64;
+// Regular page size, the granularity memory is placed on a node with.
+constexpr usize BASE_PAGE_BYTES = 4096;
+
+// NUMA node the calling thread is running on, 0 when unknown.
+inline usize current_numa_node() {
+#ifdef __linux__
+	unsigned cpu = 0, node = 0;
+	if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return std::min<usize>(node, MAX_NUMA_NODES - 1);
+#endif
+	return 0;
+}
+
+// Binds page aligned memory to a node with libnuma. Without libnuma pages are placed by first touch,
+// so the memory must first be written by a thread running on that node.
+inline void place_on_numa_node(void* memory, usize bytes, usize node) {
+#ifdef MIDNIGHT_LIBNUMA
+	if (numa_available() >= 0) numa_tonode_memory(memory, bytes, static_cast<i32>(node));
+#else
+	(void) memory; (void) bytes; (void) node;
+#endif
+}
+
+// Page aligned memory placed on the given node, never freed.
+inline void* allocate_on_numa_node(usize bytes, usize node) {
+	const usize size = (bytes + BASE_PAGE_BYTES - 1) / BASE_PAGE_BYTES * BASE_PAGE_BYTES;
+	void* memory = std::aligned_alloc(BASE_PAGE_BYTES, size);
+	if (memory == nullptr) throw std::bad_alloc();
+	place_on_numa_node(memory, size, node);
+	return memory;
+}
+
+// Pins the calling thread to one CPU, so it stays on that CPU's node. Returns false where unsupported.
+inline bool pin_thread_to_cpu(usize cpu) {
+#ifdef __linux__
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(cpu, &cpus);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+	(void) cpu;
+	return false;
+#endif
+}
+
+MIDNIGHT_NAMESPACE_END
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <iomanip>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "../types.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// A hardware event counter for the calling thread, read through perf_event_open on Linux.
+// With inherit set, threads created after the counter also count towards it.
+// Counters are unavailable on other platforms, in most virtual machines and when
+// /proc/sys/kernel/perf_event_paranoid forbids them, in which case available() is false and reads are 0.
+class PerfCounter {
+private:
+	i32 fd_ = -1;
+public:
+	PerfCounter(u32 type, u64 config, bool inherit = false) {
+#ifdef __linux__
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = 1;
+		attr.inherit = inherit;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		fd_ = static_cast<i32>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+
+	PerfCounter(const PerfCounter&) = delete;
+	PerfCounter& operator=(const PerfCounter&) = delete;
+	PerfCounter(PerfCounter&& other) noexcept : fd_(std::exchange(other.fd_, -1)) {}
+
+	~PerfCounter() {
+#ifdef __linux__
+		if (fd_ >= 0) close(fd_);
+#endif
+	}
+
+	[[nodiscard]] bool available() const { return fd_ >= 0; }
+
+	void start() {
+#ifdef __linux__
+		if (fd_ < 0) return;
+		ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+	}
+
+	void stop() {
+#ifdef __linux__
+		if (fd_ >= 0) ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+	}
+
+	// When more events are open than the core has counters, the kernel rotates them and
+	// the count is scaled up from the fraction of time the event was actually counting.
+	[[nodiscard]] u64 read() const {
+		u64 values[3] = {0, 0, 0};
+#ifdef __linux__
+		if (fd_ < 0 || ::read(fd_, values, sizeof(values)) != sizeof(values)) return 0;
+		if (values[2] && values[2] < values[1]) {
+			return static_cast<u64>(static_cast<double>(values[0]) * values[1] / values[2]);
+		}
+#endif
+		return values[0];
+	}
+
+#ifdef __linux__
+	static PerfCounter hardware(u64 event, bool inherit = false) { return {PERF_TYPE_HARDWARE, event, inherit}; }
+
+	static PerfCounter cache_read_misses(u64 cache, bool inherit = false) {
+		return {PERF_TYPE_HW_CACHE, cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+				inherit};
+	}
+
+	static PerfCounter cycles(bool inherit = false) { return hardware(PERF_COUNT_HW_CPU_CYCLES, inherit); }
+	static PerfCounter instructions(bool inherit = false) { return hardware(PERF_COUNT_HW_INSTRUCTIONS, inherit); }
+	static PerfCounter branch_misses(bool inherit = false) { return hardware(PERF_COUNT_HW_BRANCH_MISSES, inherit); }
+	// Last level cache misses.
+	static PerfCounter cache_misses(bool inherit = false) { return hardware(PERF_COUNT_HW_CACHE_MISSES, inherit); }
+	static PerfCounter l1d_load_misses(bool inherit = false) { return cache_read_misses(PERF_COUNT_HW_CACHE_L1D, inherit); }
+	// Data TLB misses on loads.
+	static PerfCounter dtlb_load_misses(bool inherit = false) { return cache_read_misses(PERF_COUNT_HW_CACHE_DTLB, inherit); }
+#else
+	static PerfCounter cycles(bool = false) { return {0, 0}; }
+	static PerfCounter instructions(bool = false) { return {0, 0}; }
+	static PerfCounter branch_misses(bool = false) { return {0, 0}; }
+	static PerfCounter cache_misses(bool = false) { return {0, 0}; }
+	static PerfCounter l1d_load_misses(bool = false) { return {0, 0}; }
+	static PerfCounter dtlb_load_misses(bool = false) { return {0, 0}; }
+#endif
+};
+
+// The counters that tell apart code bound by retirement, branch mispredictions, cache misses and TLB misses.
+// Counts are reported per unit of work, e.g. per perft node.
+class PerfCounterSet {
+private:
+	std::vector<std::pair<const char*, PerfCounter>> counters_;
+public:
+	explicit PerfCounterSet(bool inherit = false) {
+		counters_.emplace_back("cycles", PerfCounter::cycles(inherit));
+		counters_.emplace_back("instructions", PerfCounter::instructions(inherit));
+		counters_.emplace_back("branch-misses", PerfCounter::branch_misses(inherit));
+		counters_.emplace_back("cache-misses", PerfCounter::cache_misses(inherit));
+		counters_.emplace_back("L1-dcache-load-misses", PerfCounter::l1d_load_misses(inherit));
+		counters_.emplace_back("dTLB-load-misses", PerfCounter::dtlb_load_misses(inherit));
+	}
+
+	[[nodiscard]] bool available() const {
+		for (const auto& [name, counter] : counters_) if (counter.available()) return true;
+		return false;
+	}
+
+	void start() { for (auto& [name, counter] : counters_) counter.start(); }
+	void stop() { for (auto& [name, counter] : counters_) counter.stop(); }
+
+	// Names and counts of the available counters.
+	[[nodiscard]] std::vector<std::pair<const char*, u64>> read() const {
+		std::vector<std::pair<const char*, u64>> counts;
+		for (const auto& [name, counter] : counters_) if (counter.available()) counts.emplace_back(name, counter.read());
+		return counts;
+	}
+
+	void report(std::ostream& os, u64 work, const char* unit) const {
+		if (!available()) {
+			os << "Hardware counters unavailable (no PMU access or perf_event_paranoid too high)" << std::endl;
+			return;
+		}
+		u64 cycles = 0, instructions = 0;
+		for (const auto& [name, count] : read()) {
+			os << std::left << std::setw(24) << name << std::right << std::setw(16) << count << std::fixed
+			   << std::setprecision(3) << std::setw(12) << static_cast<double>(count) / static_cast<double>(work)
+			   << " per " << unit << std::endl;
+			if (name == std::string_view("cycles")) cycles = count;
+			if (name == std::string_view("instructions")) instructions = count;
+		}
+		if (cycles) os << "IPC: " << std::setprecision(2) << static_cast<double>(instructions) / cycles << std::endl;
+	}
+};
+
+MIDNIGHT_NAMESPACE_END
@@ -7,6 +7,8 @@
 #include <algorithm>
 #include "../types.h"
 
+MIDNIGHT_NAMESPACE_BEGIN
+
 // Credit to Polaris by Ciekce for massively inspiring this.
 
 template<typename T, usize Capacity>
@@ -50,4 +52,6 @@ public:
 private:
 	std::array<T, Capacity> data{};
 	usize length = 0;
-};
\ No newline at end of file
+};
+
+MIDNIGHT_NAMESPACE_END
@@ -0,0 +1,392 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../types.h"
+#include "numa.h"
+
+#ifdef MIDNIGHT_NUMA_TABLES
+#include "../move_gen/tables/attack_tables.h"
+#endif
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+inline usize default_thread_count() {
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Chase-Lev deque (Lê, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models").
+// The owning thread pushes and pops at the bottom without a compare and swap except for the last item, other threads
+// steal from the top. T is trivially copyable, e.g. a pointer. The buffer doubles when full; the buffers it replaces
+// may still be read by a thief and are freed with the deque.
+template<typename T>
+class WorkStealingDeque {
+private:
+	struct Buffer {
+		i64 mask;
+		std::unique_ptr<std::atomic<T>[]> slots;
+
+		explicit Buffer(i64 capacity) : mask(capacity - 1), slots(new std::atomic<T>[static_cast<usize>(capacity)]) {}
+		[[nodiscard]] i64 capacity() const { return mask + 1; }
+		T get(i64 i) const { return slots[static_cast<usize>(i & mask)].load(std::memory_order_relaxed); }
+		void put(i64 i, T item) { slots[static_cast<usize>(i & mask)].store(item, std::memory_order_relaxed); }
+	};
+
+	alignas(64) std::atomic<i64> top{0};
+	alignas(64) std::atomic<i64> bottom{0};
+	std::atomic<Buffer*> buffer;
+	// Every buffer the deque has had, only touched by the owner.
+	std::vector<std::unique_ptr<Buffer>> buffers;
+
+	Buffer* grow(Buffer* current, i64 t, i64 b) {
+		auto larger = std::make_unique<Buffer>(current->capacity() * 2);
+		for (i64 i = t; i < b; i++) larger->put(i, current->get(i));
+		buffers.push_back(std::move(larger));
+		return buffers.back().get();
+	}
+
+public:
+	// capacity is a power of two.
+	explicit WorkStealingDeque(i64 capacity = 256) {
+		buffers.push_back(std::make_unique<Buffer>(capacity));
+		buffer.store(buffers.back().get(), std::memory_order_relaxed);
+	}
+
+	WorkStealingDeque(const WorkStealingDeque&) = delete;
+	WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+	// Owner only.
+	void push(T item) {
+		const i64 b = bottom.load(std::memory_order_relaxed);
+		const i64 t = top.load(std::memory_order_acquire);
+		Buffer* a = buffer.load(std::memory_order_relaxed);
+		if (b - t > a->capacity() - 1) {
+			a = grow(a, t, b);
+			buffer.store(a, std::memory_order_release);
+		}
+		a->put(b, item);
+		bottom.store(b + 1, std::memory_order_release);
+	}
+
+	// Owner only, takes the item pushed last.
+	bool pop(T& item) {
+		const i64 b = bottom.load(std::memory_order_relaxed) - 1;
+		Buffer* a = buffer.load(std::memory_order_relaxed);
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		i64 t = top.load(std::memory_order_relaxed);
+		if (t > b) {
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return false;
+		}
+		item = a->get(b);
+		if (t < b) return true;
+		// The last item, which a thief may be taking at the same time.
+		const bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return won;
+	}
+
+	// Any thread, takes the item pushed first. Fails when empty or when another thread took the item first.
+	bool steal(T& item) {
+		i64 t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const i64 b = bottom.load(std::memory_order_acquire);
+		if (t >= b) return false;
+		Buffer* a = buffer.load(std::memory_order_acquire);
+		item = a->get(t);
+		return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+	// May be stale by the time it returns.
+	[[nodiscard]] bool empty() const {
+		return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+	}
+};
+
+class TaskGroup;
+
+// Work-stealing pool of worker threads. A task submitted from a worker goes to the bottom of that worker's deque and is
+// usually run by the same worker, most recent first, while idle workers steal the oldest tasks of the others, which
+// are the largest ones for divide and conquer work. Tasks submitted from other threads go through a shared queue.
+// Idle workers spin for a while before they sleep, submitting wakes a sleeping worker only when there is one.
+// With pin, worker i is pinned to CPU i modulo the number of CPUs. Workers use the NUMA table copy of their node.
+// Tasks are run through a TaskGroup, or with parallel_for.
+class ThreadPool {
+	friend TaskGroup;
+
+private:
+	struct Task {
+		void (*run)(Task*);
+	};
+
+	template<typename F>
+	struct FunctionTask : Task {
+		F f;
+		explicit FunctionTask(F&& f) : Task{&invoke}, f(std::move(f)) {}
+		static void invoke(Task* task) {
+			std::unique_ptr<FunctionTask> owned(static_cast<FunctionTask*>(task));
+			owned->f();
+		}
+	};
+
+	struct alignas(64) Worker {
+		WorkStealingDeque<Task*> deque;
+		std::thread thread;
+		// Start of the search for a victim, moved on after every steal attempt.
+		usize next_victim = 0;
+	};
+
+	// Rounds of looking for work before an idle worker sleeps.
+	static constexpr usize SPIN_ROUNDS = 64;
+
+	inline static thread_local ThreadPool* current_pool = nullptr;
+	inline static thread_local usize current_index = 0;
+	// Start of the search for a victim of threads outside the pool.
+	inline static thread_local usize outside_victim = 0;
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	bool pin;
+
+	std::mutex injected_mutex;
+	std::deque<Task*> injected;
+	std::atomic<usize> injected_count{0};
+
+	std::mutex sleep_mutex;
+	std::condition_variable sleep_cv;
+	u64 wake_epoch = 0;
+	std::atomic<usize> sleepers{0};
+	std::atomic<bool> stopping{false};
+
+	// Signalled when the last task of a group finishes, for threads outside the pool waiting on it.
+	std::mutex done_mutex;
+	std::condition_variable done_cv;
+
+	[[nodiscard]] bool on_worker() const { return current_pool == this; }
+
+	void push(Task* task) {
+		if (on_worker()) {
+			workers[current_index]->deque.push(task);
+		} else {
+			std::lock_guard lock(injected_mutex);
+			injected.push_back(task);
+			injected_count.fetch_add(1, std::memory_order_relaxed);
+		}
+		// Pairs with the fence in sleep: either the sleeper sees the task or this sees the sleeper.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleepers.load(std::memory_order_relaxed) == 0) return;
+		{
+			std::lock_guard lock(sleep_mutex);
+			wake_epoch++;
+		}
+		sleep_cv.notify_one();
+	}
+
+	bool take_injected(Task*& task) {
+		if (injected_count.load(std::memory_order_relaxed) == 0) return false;
+		std::lock_guard lock(injected_mutex);
+		if (injected.empty()) return false;
+		task = injected.front();
+		injected.pop_front();
+		injected_count.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	bool steal(usize self, Task*& task) {
+		const usize n = workers.size();
+		usize& start = self < n ? workers[self]->next_victim : outside_victim;
+		for (usize i = 0; i < n; i++) {
+			const usize victim = (start + i) % n;
+			if (victim != self && workers[victim]->deque.steal(task)) {
+				start = victim;
+				return true;
+			}
+		}
+		start = (start + 1) % n;
+		return false;
+	}
+
+	[[nodiscard]] bool has_work() const {
+		if (injected_count.load(std::memory_order_relaxed)) return true;
+		return std::any_of(workers.begin(), workers.end(), [](const auto& worker) { return !worker->deque.empty(); });
+	}
+
+	void sleep() {
+		std::unique_lock lock(sleep_mutex);
+		const u64 seen = wake_epoch;
+		sleepers.fetch_add(1, std::memory_order_relaxed);
+		lock.unlock();
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!has_work()) {
+			lock.lock();
+			sleep_cv.wait(lock, [&]() { return wake_epoch != seen || stopping.load(std::memory_order_relaxed); });
+			lock.unlock();
+		}
+		sleepers.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	void worker_loop(usize index) {
+		current_pool = this;
+		current_index = index;
+		if (pin) pin_thread_to_cpu(index % default_thread_count());
+#ifdef MIDNIGHT_NUMA_TABLES
+		tables::bind_thread_tables();
+#endif
+		while (!stopping.load(std::memory_order_relaxed)) {
+			if (run_one()) continue;
+			bool found = false;
+			for (usize round = 0; round < SPIN_ROUNDS && !found; round++) {
+				std::this_thread::yield();
+				found = has_work();
+			}
+			if (!found) sleep();
+		}
+	}
+
+public:
+	explicit ThreadPool(usize threads = default_thread_count(), bool pin = false) : pin(pin) {
+		for (usize t = 0; t < std::max<usize>(threads, 1); t++) workers.push_back(std::make_unique<Worker>());
+		for (usize t = 0; t < workers.size(); t++) {
+			workers[t]->next_victim = t + 1;
+			workers[t]->thread = std::thread([this, t]() { worker_loop(t); });
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Every group of the pool has to be waited for before.
+	~ThreadPool() {
+		{
+			std::lock_guard lock(sleep_mutex);
+			stopping = true;
+		}
+		sleep_cv.notify_all();
+		for (const auto& worker : workers) worker->thread.join();
+	}
+
+	[[nodiscard]] usize size() const { return workers.size(); }
+
+	// Index of the calling worker in [0, size()), size() on threads outside the pool.
+	[[nodiscard]] usize thread_index() const { return on_worker() ? current_index : workers.size(); }
+
+	// Runs one queued task on the calling thread: the newest of its own deque, then the oldest submitted from outside,
+	// then one stolen from another worker. False when none was found.
+	bool run_one() {
+		const usize self = thread_index();
+		Task* task = nullptr;
+		if ((self < workers.size() && workers[self]->deque.pop(task)) || take_injected(task) || steal(self, task)) {
+			task->run(task);
+			return true;
+		}
+		return false;
+	}
+};
+
+// Tasks that are waited for together. run may be called from any thread, also from tasks of the group. wait returns
+// once every task has finished; a worker waiting runs other tasks meanwhile, so tasks can wait on nested groups, and
+// other threads block. The first exception thrown by a task is rethrown by wait, tasks of the group that have not
+// started by then are skipped.
+class TaskGroup {
+private:
+	ThreadPool& pool;
+	std::atomic<usize> pending{0};
+	std::atomic<bool> failed{false};
+	std::mutex error_mutex;
+	std::exception_ptr error;
+
+	void fail() {
+		std::lock_guard lock(error_mutex);
+		if (!error) error = std::current_exception();
+		failed.store(true, std::memory_order_relaxed);
+	}
+
+	void finish() {
+		// The group may be gone once pending is 0, only the pool is touched after.
+		ThreadPool& p = pool;
+		if (pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+		std::lock_guard lock(p.done_mutex);
+		p.done_cv.notify_all();
+	}
+
+	void wait_idle() {
+		if (pool.on_worker()) {
+			while (pending.load(std::memory_order_acquire)) {
+				if (!pool.run_one()) std::this_thread::yield();
+			}
+			return;
+		}
+		std::unique_lock lock(pool.done_mutex);
+		pool.done_cv.wait(lock, [&]() { return pending.load(std::memory_order_acquire) == 0; });
+	}
+
+public:
+	explicit TaskGroup(ThreadPool& pool) : pool(pool) {}
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+	~TaskGroup() { wait_idle(); }
+
+	template<typename F>
+	void run(F&& f) {
+		pending.fetch_add(1, std::memory_order_relaxed);
+		auto body = [this, f = std::forward<F>(f)]() mutable {
+			if (!failed.load(std::memory_order_relaxed)) {
+				try {
+					f();
+				} catch (...) {
+					fail();
+				}
+			}
+			finish();
+		};
+		pool.push(new ThreadPool::FunctionTask<decltype(body)>(std::move(body)));
+	}
+
+	void wait() {
+		wait_idle();
+		if (error) {
+			std::exception_ptr thrown = error;
+			error = nullptr;
+			failed = false;
+			std::rethrow_exception(thrown);
+		}
+	}
+
+	// Whether every task has finished, for threads that do something else while they wait.
+	[[nodiscard]] bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Calls job(i) for every i below count on the pool and returns once all calls have finished. The range is split in
+// halves, one half queued and the other split further by the same thread, down to grain indices per task, so threads
+// that steal take large ranges and a task is queued per index only where the work is.
+template<typename Job>
+void parallel_for(ThreadPool& pool, usize count, Job&& job, usize grain = 1) {
+	if (count == 0) return;
+	grain = std::max<usize>(grain, 1);
+	TaskGroup group(pool);
+	struct Range {
+		TaskGroup& group;
+		Job& job;
+		usize grain;
+		void operator()(usize begin, usize end) const {
+			while (end - begin > grain) {
+				const usize middle = begin + (end - begin) / 2;
+				group.run([this, middle, end]() { (*this)(middle, end); });
+				end = middle;
+			}
+			for (usize i = begin; i < end; i++) job(i);
+		}
+	};
+	const Range range{group, job, grain};
+	group.run([&range, count]() { range(0, count); });
+	group.wait();
+}
+
+MIDNIGHT_NAMESPACE_END
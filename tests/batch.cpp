@@ -0,0 +1,113 @@
+#include "lib/doctests.h"
+#include "../src/board/position.h"
+#include "../src/move_gen/batch.h"
+#include "../src/utils/helpers.h"
+#include <fstream>
+#include <vector>
+
+TEST_SUITE_BEGIN("batch");
+
+TEST_CASE("setwise-attacks-match-tables") {
+	std::ifstream input_file("./tests/attacks.txt");
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		std::vector<string> tokens = split(input_line, ",");
+		Bitboard occupancy = std::stoull(tokens[0]);
+		auto square = static_cast<Square>(std::stoi(tokens[1]));
+		Bitboard piece = square_to_bitboard(square);
+
+		CHECK_EQ(setwise::pawn_attacks<WHITE>(piece), tables::attacks<PAWN, WHITE>(square));
+		CHECK_EQ(setwise::pawn_attacks<BLACK>(piece), tables::attacks<PAWN, BLACK>(square));
+		CHECK_EQ(setwise::knight_attacks(piece), tables::attacks<KNIGHT>(square));
+		CHECK_EQ(setwise::king_attacks(piece), tables::attacks<KING>(square));
+		CHECK_EQ(setwise::bishop_attacks(piece, ~occupancy), tables::attacks<BISHOP>(square, occupancy));
+		CHECK_EQ(setwise::rook_attacks(piece, ~occupancy), tables::attacks<ROOK>(square, occupancy));
+		CHECK_EQ(setwise::slider_attacks(piece, 0, ~occupancy), tables::attacks<ROOK>(square, occupancy));
+		CHECK_EQ(setwise::slider_attacks(0, piece, ~occupancy), tables::attacks<BISHOP>(square, occupancy));
+	}
+}
+
+template<Color Us>
+void collect_positions(Position& p, i32 depth, std::vector<Position>& positions) {
+	positions.push_back(p);
+	if (depth == 0) return;
+	for (Move move : MoveList<Us, ALL>(p)) {
+		p.play<Us>(move);
+		collect_positions<~Us>(p, depth - 1, positions);
+		p.undo<Us>(move);
+	}
+}
+
+std::vector<Position> perft_positions(i32 depth) {
+	std::vector<Position> positions;
+	std::ifstream input_file("./tests/perft_results.txt");
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		Position p(split(input_line, ";")[0]);
+		if (p.turn() == WHITE) collect_positions<WHITE>(p, depth, positions);
+		else collect_positions<BLACK>(p, depth, positions);
+	}
+	return positions;
+}
+
+template<Color Us>
+LegalityMasks scalar_legality_masks(Position& p) {
+	auto ignore = [](Move) {};
+	return MoveGenerator<Us, ALL, decltype(ignore)>(p, ignore).legality_masks();
+}
+
+template<Color c>
+void check_slider_attacks(Position& p) {
+	const Bitboard ortho = p.occupancy<c, ROOK>() | p.occupancy<c, QUEEN>();
+	const Bitboard diag = p.occupancy<c, BISHOP>() | p.occupancy<c, QUEEN>();
+
+	Bitboard expected = 0;
+	for (Bitboard b = ortho; b;) expected |= tables::attacks<ROOK>(pop_lsb(b), p.occupancy());
+	for (Bitboard b = diag; b;) expected |= tables::attacks<BISHOP>(pop_lsb(b), p.occupancy());
+	CHECK_EQ(setwise::slider_attacks(ortho, diag, ~p.occupancy()), expected);
+}
+
+TEST_CASE("setwise-slider-attacks-match-tables") {
+	for (Position& p : perft_positions(1)) {
+		check_slider_attacks<WHITE>(p);
+		check_slider_attacks<BLACK>(p);
+	}
+}
+
+TEST_CASE("batch-legality-matches-scalar") {
+	std::vector<Position> positions = perft_positions(1);
+
+	BatchBitboards bitboards;
+	BatchLegality legality;
+	for (usize base = 0; base < positions.size(); base += BATCH_LANES) {
+		const usize lanes = std::min(BATCH_LANES, positions.size() - base);
+		bitboards.load(std::span<const Position>(positions).subspan(base, lanes));
+		compute_legality(bitboards, legality);
+
+		for (usize lane = 0; lane < lanes; lane++) {
+			Position& p = positions[base + lane];
+			LegalityMasks expected = p.turn() == WHITE ? scalar_legality_masks<WHITE>(p) : scalar_legality_masks<BLACK>(p);
+			CHECK_EQ(legality.danger[lane], expected.danger);
+			CHECK_EQ(legality.checkers[lane], expected.checkers);
+			CHECK_EQ(legality.pinned[lane], expected.pinned);
+		}
+	}
+}
+
+TEST_CASE("batch-generation-matches-move-list") {
+	std::vector<Position> positions = perft_positions(1);
+	std::vector<Stack<Move, MAX_MOVES>> move_lists(positions.size());
+	generate_batch(std::span<Position>(positions), std::span<Stack<Move, MAX_MOVES>>(move_lists));
+
+	for (usize i = 0; i < positions.size(); i++) {
+		Position& p = positions[i];
+		std::vector<Move> expected;
+		if (p.turn() == WHITE) for (Move m : MoveList<WHITE, ALL>(p)) expected.push_back(m);
+		else for (Move m : MoveList<BLACK, ALL>(p)) expected.push_back(m);
+
+		REQUIRE_EQ(move_lists[i].size(), expected.size());
+		for (usize j = 0; j < expected.size(); j++) CHECK(move_lists[i][j] == expected[j]);
+	}
+}
+
+TEST_SUITE_END();
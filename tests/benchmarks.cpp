@@ -0,0 +1,459 @@
+// Micro benchmarks, skipped by default. Run with: -ts=benchmarks --no-skip
+// The CMake build compiles them into their own target, MidnightMoveGenBenchmarks, run with --no-skip.
+#include "lib/doctests.h"
+#include "../src/board/packed_position.h"
+#include "../src/board/position.h"
+#include "../src/capi/midnight.h"
+#include "../src/move_gen/batch.h"
+#include "../src/move_gen/parallel.h"
+#include "../src/move_gen/perft.h"
+#include "../src/utils/helpers.h"
+#include "../src/utils/perf_counters.h"
+#include "../src/utils/huge_pages.h"
+#include "../src/utils/numa.h"
+#include "../src/utils/thread_pool.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <atomic>
+#include <thread>
+
+namespace {
+	template<Color Us>
+	void collect_positions(Position& p, i32 depth, std::vector<PackedPosition>& positions) {
+		positions.emplace_back(p);
+		if (depth == 0) return;
+		for (Move move : MoveList<Us, ALL>(p)) {
+			p.play<Us>(move);
+			collect_positions<~Us>(p, depth - 1, positions);
+			p.undo<Us>(move);
+		}
+	}
+
+	// The positions of tests/perft_results.txt and those up to depth plies below them. They are kept packed, a
+	// Position carries its whole state history, and the timed loops decode them as they go.
+	std::vector<PackedPosition> benchmark_positions(i32 depth) {
+		std::vector<PackedPosition> positions;
+		std::ifstream input_file("./tests/perft_results.txt");
+		std::string input_line;
+		while (std::getline(input_file, input_line)) {
+			Position p(split(input_line, ";")[0]);
+			if (p.turn() == WHITE) collect_positions<WHITE>(p, depth, positions);
+			else collect_positions<BLACK>(p, depth, positions);
+		}
+		return positions;
+	}
+
+	template<typename F>
+	double time_ns(F&& f) {
+		auto start_time = std::chrono::steady_clock::now();
+		f();
+		auto end_time = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end_time - start_time).count();
+	}
+
+	struct PerftTask {
+		Position position;
+		i32 depth;
+	};
+
+	// One task per root move, so threads can share the work of a single perft.
+	template<Color Us>
+	void push_root_tasks(Position& p, i32 depth, std::vector<PerftTask>& tasks) {
+		for (Move move : MoveList<Us, ALL>(p)) {
+			p.play<Us>(move);
+			tasks.push_back({p, depth - 1});
+			p.undo<Us>(move);
+		}
+	}
+
+	// On a pool with pinned threads, which bind to the table copy of their NUMA node.
+	u64 parallel_perft(std::vector<PerftTask>& tasks, usize threads) {
+		ThreadPool pool(threads, true);
+		std::atomic<u64> nodes{0};
+		parallel_for(pool, tasks.size(), [&](usize i) {
+			Position& p = tasks[i].position;
+			nodes += p.turn() == WHITE ? perft<WHITE>(p, tasks[i].depth) : perft<BLACK>(p, tasks[i].depth);
+		});
+		return nodes;
+	}
+}
+
+TEST_SUITE_BEGIN("benchmarks" * doctest::skip());
+
+TEST_CASE("batch-legality") {
+	const std::vector<PackedPosition> positions = benchmark_positions(2);
+	constexpr i32 ITERATIONS = 20;
+	Position p;
+	std::vector<Position> lane_positions(BATCH_LANES);
+	// Decodes the lanes of the chunk starting at base, returns their number.
+	auto load_lanes = [&](usize base) {
+		const usize lanes = std::min(BATCH_LANES, positions.size() - base);
+		for (usize lane = 0; lane < lanes; lane++) lane_positions[lane].set_packed(positions[base + lane]);
+		return lanes;
+	};
+
+	Bitboard sink = 0;
+	double scalar_ns = time_ns([&]() {
+		auto ignore = [](Move) {};
+		for (i32 i = 0; i < ITERATIONS; i++) {
+			for (const PackedPosition& packed : positions) {
+				p.set_packed(packed);
+				LegalityMasks masks = p.turn() == WHITE ?
+						MoveGenerator<WHITE, ALL, decltype(ignore)>(p, ignore).legality_masks() :
+						MoveGenerator<BLACK, ALL, decltype(ignore)>(p, ignore).legality_masks();
+				sink += masks.danger ^ masks.checkers ^ masks.pinned;
+			}
+		}
+	});
+
+	double batch_ns = time_ns([&]() {
+		BatchBitboards bitboards;
+		BatchLegality legality;
+		for (i32 i = 0; i < ITERATIONS; i++) {
+			for (usize base = 0; base < positions.size(); base += BATCH_LANES) {
+				const usize lanes = load_lanes(base);
+				bitboards.load(std::span<const Position>(lane_positions).first(lanes));
+				compute_legality(bitboards, legality);
+				for (usize lane = 0; lane < lanes; lane++) sink += legality.danger[lane] ^ legality.checkers[lane] ^ legality.pinned[lane];
+			}
+		}
+	});
+
+	std::vector<Stack<Move, MAX_MOVES>> move_lists(positions.size());
+	usize scalar_moves = 0, batch_moves = 0;
+	double scalar_gen_ns = time_ns([&]() {
+		for (i32 i = 0; i < ITERATIONS; i++) {
+			for (const PackedPosition& packed : positions) {
+				p.set_packed(packed);
+				scalar_moves += p.turn() == WHITE ? MoveList<WHITE, ALL>(p).size() : MoveList<BLACK, ALL>(p).size();
+			}
+		}
+	});
+	double batch_gen_ns = time_ns([&]() {
+		for (i32 i = 0; i < ITERATIONS; i++) {
+			for (usize base = 0; base < positions.size(); base += BATCH_LANES) {
+				const usize lanes = load_lanes(base);
+				generate_batch(std::span<Position>(lane_positions).first(lanes),
+							   std::span<Stack<Move, MAX_MOVES>>(move_lists).subspan(base, lanes));
+			}
+			for (auto& list : move_lists) batch_moves += list.size();
+		}
+	});
+	CHECK_EQ(scalar_moves, batch_moves);
+
+	const double n = static_cast<double>(positions.size() * ITERATIONS);
+	std::cout << "Positions: " << positions.size() << " (checksum " << sink << ")" << std::endl;
+	std::cout << "Legality masks, scalar (ns/position): " << scalar_ns / n << std::endl;
+	std::cout << "Legality masks, batch (ns/position): " << batch_ns / n << std::endl;
+	std::cout << "Move generation, MoveList (ns/position): " << scalar_gen_ns / n << std::endl;
+	std::cout << "Move generation, generate_batch (ns/position): " << batch_gen_ns / n << std::endl;
+}
+
+template<Color c>
+Bitboard magic_slider_attacks(const Position& p) {
+	Bitboard attacks = 0;
+	Bitboard diag = p.occupancy<c, BISHOP>() | p.occupancy<c, QUEEN>();
+	while (diag) attacks |= tables::attacks<BISHOP>(pop_lsb(diag), p.occupancy());
+	Bitboard ortho = p.occupancy<c, ROOK>() | p.occupancy<c, QUEEN>();
+	while (ortho) attacks |= tables::attacks<ROOK>(pop_lsb(ortho), p.occupancy());
+	return attacks;
+}
+
+template<Color c>
+Bitboard setwise_slider_attacks(const Position& p) {
+	return setwise::slider_attacks(p.occupancy<c, ROOK>() | p.occupancy<c, QUEEN>(),
+								   p.occupancy<c, BISHOP>() | p.occupancy<c, QUEEN>(), ~p.occupancy());
+}
+
+// Danger is computed with magic lookups unless built with MIDNIGHT_SETWISE_DANGER, both are timed here.
+TEST_CASE("danger-sliders") {
+	const std::vector<PackedPosition> positions = benchmark_positions(2);
+	constexpr i32 ITERATIONS = 50;
+	Position p;
+
+	Bitboard magic_sum = 0, setwise_sum = 0;
+	double magic_ns = time_ns([&]() {
+		for (i32 i = 0; i < ITERATIONS; i++) {
+			for (const PackedPosition& packed : positions) {
+				p.set_packed(packed);
+				magic_sum += magic_slider_attacks<WHITE>(p) ^ magic_slider_attacks<BLACK>(p);
+			}
+		}
+	});
+	double setwise_ns = time_ns([&]() {
+		for (i32 i = 0; i < ITERATIONS; i++) {
+			for (const PackedPosition& packed : positions) {
+				p.set_packed(packed);
+				setwise_sum += setwise_slider_attacks<WHITE>(p) ^ setwise_slider_attacks<BLACK>(p);
+			}
+		}
+	});
+	CHECK_EQ(magic_sum, setwise_sum);
+
+	// Both sides are computed per position.
+	const double n = static_cast<double>(positions.size() * ITERATIONS * 2);
+	std::cout << "Slider attacks, magic loop (ns/side): " << magic_ns / n << std::endl;
+	std::cout << "Slider attacks, setwise (ns/side): " << setwise_ns / n << std::endl;
+}
+
+// Staged generation at a node, captures first and then all moves, with and without a shared context.
+TEST_CASE("context-reuse") {
+	const std::vector<PackedPosition> positions = benchmark_positions(2);
+	constexpr i32 ITERATIONS = 20;
+	Position p;
+
+	usize separate_moves = 0, context_moves = 0;
+	double separate_ns = time_ns([&]() {
+		for (i32 i = 0; i < ITERATIONS; i++) {
+			for (const PackedPosition& packed : positions) {
+				p.set_packed(packed);
+				if (p.turn() == WHITE) separate_moves += MoveList<WHITE, CAPTURES>(p).size() + MoveList<WHITE, ALL>(p).size();
+				else separate_moves += MoveList<BLACK, CAPTURES>(p).size() + MoveList<BLACK, ALL>(p).size();
+			}
+		}
+	});
+	double context_ns = time_ns([&]() {
+		for (i32 i = 0; i < ITERATIONS; i++) {
+			for (const PackedPosition& packed : positions) {
+				p.set_packed(packed);
+				if (p.turn() == WHITE) {
+					const GenerationContext<WHITE> context(p);
+					context_moves += MoveList<WHITE, CAPTURES>(p, context).size() + MoveList<WHITE, ALL>(p, context).size();
+				} else {
+					const GenerationContext<BLACK> context(p);
+					context_moves += MoveList<BLACK, CAPTURES>(p, context).size() + MoveList<BLACK, ALL>(p, context).size();
+				}
+			}
+		}
+	});
+	CHECK_EQ(separate_moves, context_moves);
+
+	const double n = static_cast<double>(positions.size() * ITERATIONS);
+	std::cout << "Captures then all moves, separate (ns/position): " << separate_ns / n << std::endl;
+	std::cout << "Captures then all moves, shared context (ns/position): " << context_ns / n << std::endl;
+}
+
+u64 perft_fen(const std::string& fen, i32 depth) {
+	Position p(fen);
+	return p.turn() == WHITE ? perft<WHITE>(p, depth) : perft<BLACK>(p, depth);
+}
+
+// Build with HUGE_PAGE_TABLES=1 to compare TLB misses with huge page backed tables.
+TEST_CASE("perft-nps") {
+	PerfCounter dtlb_misses = PerfCounter::dtlb_load_misses();
+	u64 nodes = 0;
+	dtlb_misses.start();
+	double ns = time_ns([&]() {
+		nodes += perft_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6);
+		nodes += perft_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5);
+	});
+	dtlb_misses.stop();
+	std::cout << "Perft nodes: " << nodes << ", NPS: " << static_cast<u64>(nodes / ns * 1e9) << std::endl;
+
+	if (dtlb_misses.available()) std::cout << "dTLB load misses: " << dtlb_misses.read() << std::endl;
+	else std::cout << "dTLB load misses: unavailable" << std::endl;
+	std::cout << "Anonymous huge pages (KiB): " << anonymous_huge_pages_kib() << std::endl;
+}
+
+// Build with NUMA_TABLES=1 to give the threads on each NUMA node their own copy of the tables.
+TEST_CASE("parallel-perft") {
+	std::vector<PerftTask> tasks;
+	Position start_position("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+	Position kiwipete("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+	push_root_tasks<WHITE>(start_position, 6, tasks);
+	push_root_tasks<WHITE>(kiwipete, 5, tasks);
+
+	const usize max_threads = std::max(1u, std::thread::hardware_concurrency());
+	u64 single_thread_nodes = 0;
+	for (usize threads = 1; threads <= max_threads; threads *= 2) {
+		u64 nodes = 0;
+		double ns = time_ns([&]() { nodes = parallel_perft(tasks, threads); });
+		if (threads == 1) single_thread_nodes = nodes;
+		CHECK_EQ(nodes, single_thread_nodes);
+		std::cout << "Threads: " << threads << ", NPS: " << static_cast<u64>(nodes / ns * 1e9) << std::endl;
+	}
+
+#ifdef MIDNIGHT_NUMA_TABLES
+	usize nodes_with_tables = 0;
+	for (auto& block : tables::numa_table_blocks) nodes_with_tables += block.load() != nullptr;
+	std::cout << "NUMA nodes with a table copy: " << nodes_with_tables << std::endl;
+#endif
+}
+
+// Scaling of for_each_position over a million packed positions, counting the legal moves of each.
+TEST_CASE("for-each-position") {
+	std::vector<PackedPosition> packed = benchmark_positions(2);
+	const usize unique_positions = packed.size();
+	while (packed.size() < 1000000) packed.push_back(packed[packed.size() % unique_positions]);
+
+	std::vector<u16> counts(packed.size());
+	const usize max_threads = default_thread_count();
+	double single_thread_ns = 0;
+	u64 single_thread_moves = 0;
+	for (usize threads = 1; threads <= max_threads; threads *= 2) {
+		ThreadPool pool(threads);
+		double ns = time_ns([&]() {
+			for_each_position(pool, packed, [&](Position& p, usize i) {
+				counts[i] = static_cast<u16>(p.turn() == WHITE ? MoveList<WHITE, ALL>(p).size() : MoveList<BLACK, ALL>(p).size());
+			});
+		});
+		u64 moves = 0;
+		for (u16 count : counts) moves += count;
+		if (threads == 1) {
+			single_thread_ns = ns;
+			single_thread_moves = moves;
+		}
+		CHECK_EQ(moves, single_thread_moves);
+		std::cout << "Threads: " << threads << ", positions/s: " << static_cast<u64>(packed.size() / ns * 1e9)
+				  << ", speedup: " << single_thread_ns / ns << std::endl;
+	}
+}
+
+// Cost of a task of the thread pool: empty tasks through parallel_for, which splits ranges in halves, and through a
+// task group filled from a worker, once with one thread and once with all. Then perft of the start position split
+// into subtrees of 3 and 4 plies, one task each, against plain perft on one thread.
+TEST_CASE("thread-pool-overhead") {
+	constexpr usize TASKS = 1 << 20;
+	const usize max_threads = default_thread_count();
+	for (usize threads : {usize(1), max_threads}) {
+		ThreadPool pool(threads);
+		std::atomic<u64> sink{0};
+		double for_ns = time_ns([&]() { parallel_for(pool, TASKS, [&](usize i) { if (i == TASKS) sink++; }); });
+		double group_ns = time_ns([&]() {
+			TaskGroup outer(pool);
+			outer.run([&]() {
+				TaskGroup group(pool);
+				for (usize i = 0; i < TASKS; i++) group.run([&]() { if (sink.load(std::memory_order_relaxed) == 1) sink++; });
+				group.wait();
+			});
+			outer.wait();
+		});
+		std::cout << "Threads: " << threads << ", parallel_for (ns/task): " << for_ns / TASKS
+				  << ", task group (ns/task): " << group_ns / TASKS << std::endl;
+		if (threads == max_threads && max_threads == 1) break;
+	}
+
+	Position start(START_FEN);
+	constexpr i32 DEPTH = 6;
+	u64 serial_nodes = 0;
+	const double serial_ns = time_ns([&]() { serial_nodes = perft<WHITE>(start, DEPTH); });
+	std::cout << "Perft " << DEPTH << ", one thread without tasks (ms): " << serial_ns / 1e6 << std::endl;
+	for (i32 split_depth : {3, 4}) {
+		for (usize threads : {usize(1), max_threads}) {
+			ThreadPool pool(threads);
+			u64 nodes = 0;
+			const double ns = time_ns([&]() {
+				const std::vector<u64> divided = parallel_divide<WHITE>(pool, start, DEPTH, split_depth);
+				for (u64 n : divided) nodes += n;
+			});
+			CHECK_EQ(nodes, serial_nodes);
+			const u64 tasks = perft<WHITE>(start, DEPTH - split_depth);
+			std::cout << "Subtrees of " << split_depth << " plies: " << tasks << " tasks, threads: " << threads
+					  << " (ms): " << ns / 1e6 << ", speedup: " << serial_ns / ns << std::endl;
+			if (max_threads == 1) break;
+		}
+	}
+}
+
+// Cost of the C API over native calls for move generation, per position of a batch call and with one call per
+// position. The native loops load the same records into one position, as the batch calls do.
+TEST_CASE("capi-overhead") {
+	const std::vector<PackedPosition> packed = benchmark_positions(2);
+	// The fastest of several runs, the differences are small next to the noise of a single run.
+	constexpr i32 ITERATIONS = 4, RUNS = 5;
+	const usize n_positions = packed.size();
+
+	std::vector<midnight_packed_position> records(n_positions);
+	std::vector<string> fen_strings;
+	std::vector<const char*> fens;
+	for (usize i = 0; i < n_positions; i++) {
+		std::memcpy(records[i].bytes, &packed[i], sizeof(PackedPosition));
+		fen_strings.push_back(packed[i].fen());
+	}
+	for (const string& fen : fen_strings) fens.push_back(fen.c_str());
+
+	std::vector<midnight_move> moves(n_positions * MIDNIGHT_MAX_MOVES);
+	std::vector<uint16_t> counts(n_positions);
+	u64 native_moves = 0, batch_moves = 0, single_moves = 0, native_fen_moves = 0, batch_fen_moves = 0;
+	Position p;
+	auto generate_into = [&](usize i) {
+		usize count = 0;
+		auto push = [&](Move move) { moves[i * MIDNIGHT_MAX_MOVES + count++] = move.raw(); };
+		if (p.turn() == WHITE) generate<WHITE>(p, push);
+		else generate<BLACK>(p, push);
+		return count;
+	};
+
+	auto fastest = [](auto&& f) {
+		double best = time_ns(f);
+		for (i32 run = 1; run < RUNS; run++) best = std::min(best, time_ns(f));
+		return best;
+	};
+
+	double native_ns = fastest([&]() {
+		for (i32 it = 0; it < ITERATIONS; it++) {
+			for (usize i = 0; i < n_positions; i++) {
+				p.set_packed(packed[i]);
+				native_moves += generate_into(i);
+			}
+		}
+	});
+	double batch_ns = fastest([&]() {
+		for (i32 it = 0; it < ITERATIONS; it++) {
+			REQUIRE_EQ(midnight_generate_packed(records.data(), n_positions, moves.data(), counts.data(), nullptr), MIDNIGHT_OK);
+			for (uint16_t count : counts) batch_moves += count;
+		}
+	});
+	double single_ns = fastest([&]() {
+		for (i32 it = 0; it < ITERATIONS; it++) {
+			for (usize i = 0; i < n_positions; i++) {
+				midnight_generate_packed(&records[i], 1, &moves[i * MIDNIGHT_MAX_MOVES], &counts[i], nullptr);
+				single_moves += counts[i];
+			}
+		}
+	});
+	double native_fen_ns = fastest([&]() {
+		for (i32 it = 0; it < ITERATIONS; it++) {
+			for (usize i = 0; i < n_positions; i++) {
+				p.set_fen(fen_strings[i]);
+				native_fen_moves += generate_into(i);
+			}
+		}
+	});
+	double batch_fen_ns = fastest([&]() {
+		for (i32 it = 0; it < ITERATIONS; it++) {
+			REQUIRE_EQ(midnight_generate_fens(fens.data(), n_positions, moves.data(), counts.data(), nullptr), MIDNIGHT_OK);
+			for (uint16_t count : counts) batch_fen_moves += count;
+		}
+	});
+	CHECK_EQ(native_moves, batch_moves);
+	CHECK_EQ(native_moves, single_moves);
+	CHECK_EQ(native_moves, native_fen_moves);
+	CHECK_EQ(native_moves, batch_fen_moves);
+
+	const double n = static_cast<double>(n_positions * ITERATIONS);
+	std::cout << "Positions: " << n_positions << std::endl;
+	std::cout << "Packed, native set_packed + generate (ns/position): " << native_ns / n << std::endl;
+	std::cout << "Packed, C API batch (ns/position): " << batch_ns / n
+			  << ", overhead " << (batch_ns - native_ns) / n << std::endl;
+	std::cout << "Packed, C API call per position (ns/position): " << single_ns / n
+			  << ", overhead " << (single_ns - native_ns) / n << std::endl;
+	std::cout << "FEN, native set_fen + generate (ns/position): " << native_fen_ns / n << std::endl;
+	std::cout << "FEN, C API batch with validation (ns/position): " << batch_fen_ns / n
+			  << ", overhead " << (batch_fen_ns - native_fen_ns) / n << std::endl;
+}
+
+#ifdef MIDNIGHT_RUNTIME_TABLES
+TEST_CASE("table-initialization") {
+	constexpr i32 ITERATIONS = 20;
+	double ns = time_ns([&]() {
+		for (i32 i = 0; i < ITERATIONS; i++) tables::initialize_tables();
+	});
+	std::cout << "Table initialization (us): " << ns / ITERATIONS / 1000 << std::endl;
+}
+#endif
+
+TEST_SUITE_END();
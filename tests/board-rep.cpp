@@ -1,6 +1,10 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "lib/doctests.h"
+#include "../src/board/packed_position.h"
 #include "../src/board/position.h"
+#include "../src/move_gen/move_generator.h"
+#include "../src/utils/helpers.h"
+#include <fstream>
 
 TEST_SUITE_BEGIN("board-rep");
 constexpr ZobristHash START_POS_HASH = 0x2278897016d03aa6;
@@ -274,4 +278,35 @@ TEST_CASE("promotions") {
 	}
 }
 
+template<Color Us>
+void check_packed_tree(Position& p, i32 depth) {
+	const PackedPosition packed(p);
+	std::stringstream stream;
+	write_packed(stream, packed);
+	const std::vector<PackedPosition> read = read_packed(stream);
+	REQUIRE_EQ(read.size(), 1);
+	CHECK_EQ(read[0].fen(), p.fen());
+
+	Position unpacked;
+	unpacked.set_packed(read[0]);
+	CHECK_EQ(unpacked.fen(), p.fen());
+	CHECK_EQ(unpacked.hash(), p.hash());
+	if (depth == 0) return;
+	for (Move move : MoveList<Us, ALL>(p)) {
+		p.play<Us>(move);
+		check_packed_tree<~Us>(p, depth - 1);
+		p.undo<Us>(move);
+	}
+}
+
+TEST_CASE("packed-position-round-trip") {
+	std::ifstream input_file("./tests/perft_results.txt");
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		Position p(split(input_line, ";")[0]);
+		if (p.turn() == WHITE) check_packed_tree<WHITE>(p, 2);
+		else check_packed_tree<BLACK>(p, 2);
+	}
+}
+
 TEST_SUITE_END();
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "lib/doctests.h"
+#include "../src/capi/midnight.h"
+#include "../src/board/packed_position.h"
+#include "../src/board/position.h"
+#include "../src/move_gen/move_generator.h"
+#include "../src/utils/helpers.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+TEST_SUITE_BEGIN("capi");
+
+struct PerftLine {
+	string fen;
+	u64 depth_3;
+};
+
+std::vector<PerftLine> perft_lines() {
+	std::vector<PerftLine> lines;
+	std::ifstream input_file("./tests/perft_results.txt");
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		const std::vector<string> fields = split(input_line, ";");
+		lines.push_back({fields[0], std::stoull(split(fields[3], " ")[2])});
+	}
+	return lines;
+}
+
+template<Color Us>
+std::vector<u16> native_moves(Position& p) {
+	std::vector<u16> moves;
+	for (Move move : MoveList<Us, ALL>(p)) moves.push_back(move.raw());
+	return moves;
+}
+
+TEST_CASE("capi-batch-generate") {
+	const std::vector<PerftLine> lines = perft_lines();
+	std::vector<const char*> fens;
+	std::vector<midnight_packed_position> packed(lines.size());
+	for (usize i = 0; i < lines.size(); i++) {
+		fens.push_back(lines[i].fen.c_str());
+		const PackedPosition record{Position(lines[i].fen)};
+		std::memcpy(packed[i].bytes, &record, sizeof(record));
+	}
+
+	std::vector<midnight_move> from_fens(lines.size() * MIDNIGHT_MAX_MOVES), from_packed(from_fens.size());
+	std::vector<uint16_t> fen_counts(lines.size()), packed_counts(lines.size());
+	REQUIRE_EQ(midnight_generate_fens(fens.data(), fens.size(), from_fens.data(), fen_counts.data(), nullptr), MIDNIGHT_OK);
+	REQUIRE_EQ(midnight_generate_packed(packed.data(), packed.size(), from_packed.data(), packed_counts.data(), nullptr),
+			   MIDNIGHT_OK);
+
+	for (usize i = 0; i < lines.size(); i++) {
+		Position p(lines[i].fen);
+		const std::vector<u16> expected = p.turn() == WHITE ? native_moves<WHITE>(p) : native_moves<BLACK>(p);
+		const midnight_move* fen_moves = &from_fens[i * MIDNIGHT_MAX_MOVES];
+		const midnight_move* packed_moves = &from_packed[i * MIDNIGHT_MAX_MOVES];
+		CHECK_EQ(std::vector<u16>(fen_moves, fen_moves + fen_counts[i]), expected);
+		CHECK_EQ(std::vector<u16>(packed_moves, packed_moves + packed_counts[i]), expected);
+	}
+}
+
+TEST_CASE("capi-batch-perft") {
+	const std::vector<PerftLine> lines = perft_lines();
+	std::vector<const char*> fens;
+	for (const PerftLine& line : lines) fens.push_back(line.fen.c_str());
+
+	std::vector<uint64_t> nodes(lines.size());
+	REQUIRE_EQ(midnight_perft_fens(fens.data(), fens.size(), 3, nodes.data(), nullptr), MIDNIGHT_OK);
+	for (usize i = 0; i < lines.size(); i++) CHECK_EQ(nodes[i], lines[i].depth_3);
+
+	midnight_position* position = nullptr;
+	REQUIRE_EQ(midnight_position_new(fens[1], &position), MIDNIGHT_OK);
+	midnight_packed_position packed;
+	REQUIRE_EQ(midnight_position_pack(position, &packed), MIDNIGHT_OK);
+	uint64_t packed_nodes = 0;
+	CHECK_EQ(midnight_perft_packed(&packed, 1, 3, &packed_nodes, nullptr), MIDNIGHT_OK);
+	CHECK_EQ(packed_nodes, lines[1].depth_3);
+	midnight_position_free(position);
+}
+
+TEST_CASE("capi-play-undo") {
+	midnight_position* position = nullptr;
+	REQUIRE_EQ(midnight_position_new(nullptr, &position), MIDNIGHT_OK);
+	const uint64_t start_hash = midnight_position_hash(position);
+
+	size_t played = 0;
+	CHECK_EQ(midnight_position_play_uci(position, "e2e4 d7d5 e4d5 g8f6 g1f1", &played), MIDNIGHT_ILLEGAL_MOVE);
+	CHECK_EQ(played, 4);
+	CHECK_EQ(midnight_position_ply(position), 4);
+
+	char fen[MIDNIGHT_FEN_SIZE];
+	REQUIRE_EQ(midnight_position_fen(position, fen, sizeof(fen)), MIDNIGHT_OK);
+	CHECK_EQ(string(fen), "rnbqkb1r/ppp1pppp/5n2/3P4/8/8/PPPP1PPP/RNBQKBNR w KQkq - 0 1");
+	CHECK_EQ(midnight_position_hash(position), Position(fen).hash());
+	CHECK_EQ(midnight_position_fen(position, fen, 10), MIDNIGHT_BUFFER_TOO_SMALL);
+
+	midnight_move moves[MIDNIGHT_MAX_MOVES];
+	const size_t count = midnight_position_moves(position, moves);
+	REQUIRE_GT(count, 0);
+	char uci[MIDNIGHT_UCI_SIZE];
+	REQUIRE_EQ(midnight_move_to_uci(moves[0], uci, sizeof(uci)), MIDNIGHT_OK);
+	CHECK_EQ(midnight_position_play(position, moves, 1, &played), MIDNIGHT_OK);
+	CHECK_EQ(played, 1);
+	CHECK_EQ(midnight_position_undo(position, 1), MIDNIGHT_OK);
+	CHECK_EQ(midnight_position_play_uci(position, uci, &played), MIDNIGHT_OK);
+
+	// Moves of the previous position are not legal anymore.
+	CHECK_EQ(midnight_position_play(position, moves, 1, &played), MIDNIGHT_ILLEGAL_MOVE);
+	CHECK_EQ(played, 0);
+	CHECK_EQ(midnight_position_undo(position, 6), MIDNIGHT_INVALID_ARGUMENT);
+	CHECK_EQ(midnight_position_undo(position, 5), MIDNIGHT_OK);
+	CHECK_EQ(midnight_position_hash(position), start_hash);
+	REQUIRE_EQ(midnight_position_fen(position, fen, sizeof(fen)), MIDNIGHT_OK);
+	CHECK_EQ(string(fen), START_FEN);
+
+	CHECK_EQ(midnight_position_play_uci(position, "e2e4 e7e5 e1g1", &played), MIDNIGHT_ILLEGAL_MOVE);
+	CHECK_EQ(midnight_position_play_uci(position, "g1f3 g8f6 f1e2 f8e7 e1g1", &played), MIDNIGHT_OK);
+	REQUIRE_EQ(midnight_position_fen(position, fen, sizeof(fen)), MIDNIGHT_OK);
+	CHECK_EQ(string(fen), "rnbqk2r/ppppbppp/5n2/4p3/4P3/5N2/PPPPBPPP/RNBQ1RK1 b kq - 0 1");
+	midnight_position_free(position);
+}
+
+TEST_CASE("capi-max-ply-and-depth") {
+	midnight_position* position = nullptr;
+	REQUIRE_EQ(midnight_position_new(nullptr, &position), MIDNIGHT_OK);
+	size_t played = 0;
+	// Knights back and forth, then fool's mate as moves 509 to 512.
+	for (i32 i = 0; i < (MIDNIGHT_MAX_PLY - 4) / 4; i++) {
+		REQUIRE_EQ(midnight_position_play_uci(position, "g1f3 g8f6 f3g1 f6g8", &played), MIDNIGHT_OK);
+	}
+	REQUIRE_EQ(midnight_position_play_uci(position, "f2f3 e7e5 g2g4", &played), MIDNIGHT_OK);
+	REQUIRE_EQ(midnight_position_ply(position), MIDNIGHT_MAX_PLY - 1);
+
+	char fen[MIDNIGHT_FEN_SIZE];
+	REQUIRE_EQ(midnight_position_fen(position, fen, sizeof(fen)), MIDNIGHT_OK);
+	midnight_position* fresh = nullptr;
+	REQUIRE_EQ(midnight_position_new(fen, &fresh), MIDNIGHT_OK);
+	uint64_t nodes = 0, fresh_nodes = 0;
+	REQUIRE_EQ(midnight_position_perft(position, 3, &nodes), MIDNIGHT_OK);
+	REQUIRE_EQ(midnight_position_perft(fresh, 3, &fresh_nodes), MIDNIGHT_OK);
+	CHECK_EQ(nodes, fresh_nodes);
+	midnight_position_free(fresh);
+
+	REQUIRE_EQ(midnight_position_play_uci(position, "d8h4", &played), MIDNIGHT_OK);
+	CHECK_EQ(midnight_position_ply(position), MIDNIGHT_MAX_PLY);
+	CHECK_EQ(midnight_position_play_uci(position, "e1f2", &played), MIDNIGHT_ILLEGAL_MOVE);
+
+	CHECK_EQ(midnight_position_perft(position, MIDNIGHT_MAX_DEPTH, &nodes), MIDNIGHT_OK);
+	CHECK_EQ(nodes, 0);
+	CHECK_EQ(midnight_position_perft(position, MIDNIGHT_MAX_DEPTH + 1, &nodes), MIDNIGHT_INVALID_ARGUMENT);
+	CHECK_EQ(midnight_position_perft(position, MIDNIGHT_MAX_PLY, &nodes), MIDNIGHT_INVALID_ARGUMENT);
+	midnight_position_free(position);
+}
+
+TEST_CASE("capi-invalid-input") {
+	const char* invalid_fens[] = {
+			"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq",
+			"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0",
+			"rnbqkbnr/ppppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+			"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1",
+			"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNX w KQkq - 0 1",
+			"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1",
+			"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkqK - 0 1",
+			"8/8/8/8/8/8/8/8 w - - 0 1",
+			"4k3/8/8/8/8/8/8/4K3 w K - 0 1",
+			"4k3/8/8/8/8/8/8/r3K3 b - - 0 1",
+			"4k3/8/8/8/8/8/8/P3K3 w - - 0 1",
+			"4k3/8/8/8/8/8/QQQQQQQQ/QQQQK3 w - - 0 1",
+			"4k3/8/8/3p4/8/8/8/4K3 w - e6 0 1",
+			"4k3/8/8/8/3P4/8/8/4K3 b - d6 0 1",
+	};
+	for (const char* fen : invalid_fens) {
+		midnight_position* position = nullptr;
+		CHECK_MESSAGE(midnight_position_new(fen, &position) == MIDNIGHT_INVALID_POSITION, fen);
+		CHECK_EQ(position, nullptr);
+	}
+
+	const char* batch[] = {START_FEN.c_str(), invalid_fens[0], START_FEN.c_str()};
+	std::vector<midnight_move> moves(3 * MIDNIGHT_MAX_MOVES);
+	uint16_t counts[3] = {};
+	size_t error_index = 0;
+	CHECK_EQ(midnight_generate_fens(batch, 3, moves.data(), counts, &error_index), MIDNIGHT_INVALID_POSITION);
+	CHECK_EQ(error_index, 1);
+	CHECK_EQ(counts[0], 20);
+	CHECK_EQ(counts[2], 0);
+	CHECK_EQ(midnight_generate_fens(batch, 3, nullptr, counts, &error_index), MIDNIGHT_INVALID_ARGUMENT);
+	CHECK_EQ(midnight_generate_fens(nullptr, 0, nullptr, nullptr, nullptr), MIDNIGHT_OK);
+
+	uint64_t nodes = 0;
+	CHECK_EQ(midnight_perft_fens(batch, 1, -1, &nodes, nullptr), MIDNIGHT_INVALID_ARGUMENT);
+
+	midnight_packed_position packed;
+	const PackedPosition start{Position(START_FEN)};
+	std::memcpy(packed.bytes, &start, sizeof(start));
+	packed.bytes[20] = 0x66;
+	CHECK_EQ(midnight_perft_packed(&packed, 1, 1, &nodes, &error_index), MIDNIGHT_INVALID_POSITION);
+	CHECK_EQ(error_index, 0);
+
+	CHECK_EQ(midnight_position_new(START_FEN.c_str(), nullptr), MIDNIGHT_INVALID_ARGUMENT);
+	midnight_position_free(nullptr);
+}
+
+TEST_SUITE_END();
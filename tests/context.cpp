@@ -0,0 +1,54 @@
+#include "lib/doctests.h"
+#include "../src/board/position.h"
+#include "../src/move_gen/move_generator.h"
+#include "../src/utils/helpers.h"
+#include <fstream>
+#include <vector>
+
+TEST_SUITE_BEGIN("context");
+
+template<Color color>
+Bitboard recomputed_occupancy(const Position& p) {
+	Bitboard occupancy = 0;
+	for (u32 pt = PAWN; pt <= KING; pt++) occupancy |= p.occupancy(Piece((color << 3) | pt));
+	return occupancy;
+}
+
+template<typename List>
+std::vector<u16> moves_of(const List& list) {
+	std::vector<u16> moves;
+	for (Move m : list) moves.push_back(m.raw());
+	return moves;
+}
+
+template<Color Us>
+void check_context_tree(Position& p, i32 depth) {
+	CHECK_EQ(p.occupancy<WHITE>(), recomputed_occupancy<WHITE>(p));
+	CHECK_EQ(p.occupancy<BLACK>(), recomputed_occupancy<BLACK>(p));
+	CHECK_EQ(p.occupancy(), recomputed_occupancy<WHITE>(p) | recomputed_occupancy<BLACK>(p));
+
+	// One context serves every generation type at this node.
+	const GenerationContext<Us> context(p);
+	CHECK_EQ(moves_of(MoveList<Us, CAPTURES>(p, context)), moves_of(MoveList<Us, CAPTURES>(p)));
+	CHECK_EQ(moves_of(MoveList<Us, ALL>(p, context)), moves_of(MoveList<Us, ALL>(p)));
+	CHECK_EQ(moves_of(MoveList<Us, ANY>(p, context)), moves_of(MoveList<Us, ANY>(p)));
+
+	if (depth == 0) return;
+	for (Move move : MoveList<Us, ALL>(p)) {
+		p.play<Us>(move);
+		check_context_tree<~Us>(p, depth - 1);
+		p.undo<Us>(move);
+	}
+}
+
+TEST_CASE("incremental-occupancy-and-context") {
+	std::ifstream input_file("./tests/perft_results.txt");
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		Position p(split(input_line, ";")[0]);
+		if (p.turn() == WHITE) check_context_tree<WHITE>(p, 2);
+		else check_context_tree<BLACK>(p, 2);
+	}
+}
+
+TEST_SUITE_END();
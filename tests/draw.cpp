@@ -0,0 +1,87 @@
+#include "lib/doctests.h"
+#include "../src/board/position.h"
+
+TEST_SUITE_BEGIN("draw");
+
+TEST_CASE("insufficient-material") {
+	CHECK(Position("8/8/4k3/8/8/3K4/8/8 w - - 0 1").has_insufficient_material());
+	CHECK(Position("8/8/4k3/8/8/3K4/8/6N1 w - - 0 1").has_insufficient_material());
+	CHECK(Position("8/8/4k3/8/8/3K4/8/6b1 w - - 0 1").has_insufficient_material());
+	CHECK(Position("8/8/4k3/8/3B4/3K4/8/6b1 w - - 0 1").has_insufficient_material());
+
+	CHECK_FALSE(Position("8/8/4k3/8/2B5/3K4/8/6b1 w - - 0 1").has_insufficient_material());
+	CHECK_FALSE(Position("8/8/4k3/8/8/3K4/8/5nb1 w - - 0 1").has_insufficient_material());
+	CHECK_FALSE(Position("8/8/4k3/8/8/3K4/6P1/8 w - - 0 1").has_insufficient_material());
+	CHECK_FALSE(Position("8/8/4k3/8/8/3K4/8/6r1 w - - 0 1").has_insufficient_material());
+	CHECK_FALSE(Position(START_FEN).has_insufficient_material());
+}
+
+TEST_CASE("has-legal-move") {
+	CHECK(Position(START_FEN).has_legal_move());
+	CHECK(Position(KIWIPETE_FEN).has_legal_move());
+
+	// Fool's mate.
+	Position mated("rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3");
+	CHECK(mated.in_check());
+	CHECK_FALSE(mated.has_legal_move());
+
+	Position stalemate("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+	CHECK_FALSE(stalemate.in_check());
+	CHECK_FALSE(stalemate.has_legal_move());
+}
+
+TEST_CASE("fifty-move-rule") {
+	Position p("8/8/4k3/8/8/3K4/6R1/8 w - - 0 1");
+	CHECK_FALSE(p.is_draw(0));
+
+	for (i32 i = 0; i < 25; i++) {
+		p.play<WHITE>(Move(g2, g3, QUIET));
+		p.play<BLACK>(Move(e6, e7, QUIET));
+		p.play<WHITE>(Move(g3, g2, QUIET));
+		p.play<BLACK>(Move(e7, e6, QUIET));
+	}
+	CHECK_EQ(p.fifty_move_rule(), 100);
+	CHECK(p.is_draw(0));
+
+	// Checkmate takes precedence over the fifty-move rule, when the hundredth reversible ply mates.
+	Position mated("1n4k1/5ppp/8/8/8/8/8/3R3K b - - 0 1");
+	for (i32 i = 0; i < 25; i++) {
+		mated.play<BLACK>(Move(b8, c6, QUIET));
+		mated.play<WHITE>(Move(h1, h2, QUIET));
+		mated.play<BLACK>(Move(c6, b8, QUIET));
+		if (i < 24) mated.play<WHITE>(Move(h2, h1, QUIET));
+	}
+	mated.play<WHITE>(Move(d1, d7, QUIET));
+	CHECK_EQ(mated.fifty_move_rule(), 100);
+	CHECK(mated.is_draw(0));
+	mated.undo<WHITE>(Move(d1, d7, QUIET));
+
+	mated.play<WHITE>(Move(d1, d8, QUIET));
+	CHECK_EQ(mated.fifty_move_rule(), 100);
+	CHECK(mated.in_check());
+	CHECK_FALSE(mated.has_legal_move());
+	CHECK_FALSE(mated.is_draw(0));
+}
+
+TEST_CASE("repetition") {
+	Position p(START_FEN);
+	p.play<WHITE>(Move(g1, f3, QUIET));
+	p.play<BLACK>(Move(g8, f6, QUIET));
+	p.play<WHITE>(Move(f3, g1, QUIET));
+	p.play<BLACK>(Move(f6, g8, QUIET));
+
+	// Repeated inside the search tree, a single repetition is enough.
+	CHECK(p.is_draw(5));
+	// Repeating the root itself is not inside the tree.
+	CHECK_FALSE(p.is_draw(4));
+	// Repeated before the root, a third occurrence is required.
+	CHECK_FALSE(p.is_draw(0));
+
+	p.play<WHITE>(Move(g1, f3, QUIET));
+	p.play<BLACK>(Move(g8, f6, QUIET));
+	p.play<WHITE>(Move(f3, g1, QUIET));
+	p.play<BLACK>(Move(f6, g8, QUIET));
+	CHECK(p.is_draw(0));
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,73 @@
+#include "lib/doctests.h"
+#include "../src/board/position.h"
+#include "../src/move_gen/move_generator.h"
+#include "../src/utils/helpers.h"
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+TEST_SUITE_BEGIN("filter");
+
+template<typename List>
+std::vector<u16> sorted_moves(const List& list) {
+	std::vector<u16> moves;
+	for (Move m : list) moves.push_back(m.raw());
+	std::sort(moves.begin(), moves.end());
+	return moves;
+}
+
+template<Color Us>
+void check_filters(Position& p) {
+	MoveList<Us, ALL> all(p);
+
+	for (Square sq = a1; sq < NSQUARES; sq++) {
+		std::vector<u16> expected;
+		for (Move m : all) if (m.from() == sq) expected.push_back(m.raw());
+		std::sort(expected.begin(), expected.end());
+
+		MoveList<Us, ALL> filtered(p, MoveFilter{square_to_bitboard(sq)});
+		CHECK_EQ(sorted_moves(filtered), expected);
+		CHECK_EQ(MoveList<Us, ANY>(p, MoveFilter{square_to_bitboard(sq)}).size(), std::min<usize>(expected.size(), 1));
+	}
+
+	for (u32 pt = PAWN; pt <= KING; pt++) {
+		std::vector<u16> expected;
+		for (Move m : all) if (type_of(p.piece_at(m.from())) == PieceType(pt)) expected.push_back(m.raw());
+		std::sort(expected.begin(), expected.end());
+
+		MoveList<Us, ALL> filtered(p, MoveFilter{~0ULL, piece_type_bit(PieceType(pt))});
+		CHECK_EQ(sorted_moves(filtered), expected);
+	}
+}
+
+template<Color Us>
+void check_filters_tree(Position& p, i32 depth) {
+	check_filters<Us>(p);
+	if (depth == 0) return;
+	for (Move move : MoveList<Us, ALL>(p)) {
+		p.play<Us>(move);
+		check_filters_tree<~Us>(p, depth - 1);
+		p.undo<Us>(move);
+	}
+}
+
+TEST_CASE("filtered-generation") {
+	std::ifstream input_file("./tests/perft_results.txt");
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		Position p(split(input_line, ";")[0]);
+		if (p.turn() == WHITE) check_filters_tree<WHITE>(p, 1);
+		else check_filters_tree<BLACK>(p, 1);
+	}
+}
+
+TEST_CASE("combined-filter") {
+	Position p(KIWIPETE_FEN);
+	// Knights on the queen side only.
+	MoveList<WHITE, ALL> list(p, MoveFilter{MASK_FILE[AFILE] | MASK_FILE[BFILE] | MASK_FILE[CFILE] | MASK_FILE[DFILE],
+											piece_type_bit(KNIGHT)});
+	CHECK_EQ(list.size(), 4);
+	for (Move m : list) CHECK_EQ(m.from(), c3);
+}
+
+TEST_SUITE_END();
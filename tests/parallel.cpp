@@ -0,0 +1,84 @@
+#include "lib/doctests.h"
+#include "../src/board/packed_position.h"
+#include "../src/board/position.h"
+#include "../src/move_gen/move_generator.h"
+#include "../src/move_gen/parallel.h"
+#include "../src/utils/helpers.h"
+#include <fstream>
+#include <vector>
+
+TEST_SUITE_BEGIN("parallel");
+
+template<Color Us>
+void collect_fens(Position& p, i32 depth, std::vector<string>& fens) {
+	fens.push_back(p.fen());
+	if (depth == 0) return;
+	for (Move move : MoveList<Us, ALL>(p)) {
+		p.play<Us>(move);
+		collect_fens<~Us>(p, depth - 1, fens);
+		p.undo<Us>(move);
+	}
+}
+
+// The positions of tests/perft_results.txt and their children, enough inputs for every thread to steal.
+std::vector<string> parallel_fens() {
+	std::vector<string> fens;
+	std::ifstream input_file("./tests/perft_results.txt");
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		Position p(split(input_line, ";")[0]);
+		if (p.turn() == WHITE) collect_fens<WHITE>(p, 1, fens);
+		else collect_fens<BLACK>(p, 1, fens);
+	}
+	return fens;
+}
+
+TEST_CASE("for-each-position-matches-serial") {
+	const std::vector<string> fens = parallel_fens();
+	std::vector<PackedPosition> packed;
+	std::vector<ZobristHash> expected_hashes;
+	std::vector<u64> expected_nodes;
+	std::vector<usize> expected_moves;
+	for (const string& fen : fens) {
+		Position p(fen);
+		packed.emplace_back(p);
+		expected_hashes.push_back(p.hash());
+		expected_nodes.push_back(p.turn() == WHITE ? perft<WHITE>(p, 2) : perft<BLACK>(p, 2));
+		expected_moves.push_back(p.turn() == WHITE ? MoveList<WHITE, ALL>(p).size() : MoveList<BLACK, ALL>(p).size());
+	}
+
+	for (usize threads : {1, 3, 8}) {
+		ThreadPool pool(threads);
+		std::vector<ZobristHash> hashes(fens.size());
+		std::vector<u64> nodes(fens.size());
+		hash_all(pool, fens, std::span(hashes));
+		perft_all(pool, packed, 2, std::span(nodes));
+		CHECK_EQ(hashes, expected_hashes);
+		CHECK_EQ(nodes, expected_nodes);
+
+		std::vector<Stack<Move, MAX_MOVES>> move_lists(fens.size());
+		generate_all(pool, packed, std::span(move_lists));
+		for (usize i = 0; i < fens.size(); i++) CHECK_EQ(move_lists[i].size(), expected_moves[i]);
+
+		std::vector<u32> visits(fens.size());
+		for_each_position(pool, fens, [&](Position& p, usize i) {
+			visits[i]++;
+			CHECK_EQ(p.hash(), expected_hashes[i]);
+		});
+		CHECK(std::all_of(visits.begin(), visits.end(), [](u32 count) { return count == 1; }));
+	}
+}
+
+TEST_CASE("for-each-position-rethrows") {
+	std::vector<string> fens = parallel_fens();
+	fens[fens.size() / 2] = "8/8/8/8";
+	ThreadPool pool(4);
+	std::vector<ZobristHash> hashes(fens.size());
+	CHECK_THROWS_AS(hash_all(pool, fens, std::span(hashes)), std::invalid_argument);
+	CHECK_THROWS_AS(hash_all(pool, fens, std::span(hashes).first(1)), std::invalid_argument);
+	CHECK_THROWS_AS(for_each_position(pool, fens, [](Position&, usize i) {
+		if (i == 7) throw std::runtime_error("visit");
+	}), std::runtime_error);
+}
+
+TEST_SUITE_END();
@@ -1,10 +1,12 @@
 #include "lib/doctests.h"
 #include "../src/board/position.h"
 #include "../src/move_gen/move_generator.h"
+#include "../src/move_gen/perft.h"
 #include "iostream"
 #include "fstream"
 #include "../src/utils/helpers.h"
 #include <chrono>
+#include <algorithm>
 
 template<Color Us>
 u64 perft_node_count(Position& p, i32 depth) {
@@ -29,8 +31,37 @@ u64 test_perft_node_count(const std::string& fen, i32 depth) {
 	}
 }
 
+template<Color Us>
+void check_any_legal_move(Position& p, i32 depth) {
+	MoveList<Us, ALL> list(p);
+	MoveList<Us, ANY> any(p);
+
+	CHECK_EQ(any.size(), std::min<usize>(list.size(), 1));
+	if (any.size()) CHECK_NE(std::find(list.begin(), list.end(), *any.begin()), list.end());
+	CHECK_EQ(is_checkmate<Us>(p), p.in_check() && list.size() == 0);
+	CHECK_EQ(is_stalemate<Us>(p), !p.in_check() && list.size() == 0);
+
+	if (depth == 0) return;
+	for (Move move : list) {
+		p.play<Us>(move);
+		check_any_legal_move<~Us>(p, depth - 1);
+		p.undo<Us>(move);
+	}
+}
+
 TEST_SUITE_BEGIN("perft-final");
 
+TEST_CASE("any-legal-move") {
+	std::ifstream input_file("./tests/perft_results.txt");
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		Position p(split(input_line, ";")[0]);
+		if (p.turn() == WHITE) check_any_legal_move<WHITE>(p, 2);
+		else check_any_legal_move<BLACK>(p, 2);
+	}
+}
+
+
 TEST_CASE("PerftDepthSixDefaultFen") {
 	CHECK_EQ(test_perft_node_count(START_FEN, 6), 119060324);
 }
@@ -67,6 +98,56 @@ TEST_CASE("PerftTestPositionKnightCheck"){
 	CHECK_EQ(test_perft_node_count("5n2/3KPk2/8/3p1N2/3P4/8/8/8 w - - 17 102", 8), 80433958);
 }
 
+TEST_CASE("perft-stats") {
+	std::ifstream input_file("./tests/perft_stats.txt");
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		std::vector<std::string> split_perft = split(input_line, ";");
+		Position p(split_perft[0]);
+		for (usize i = 1; i < split_perft.size(); i++) {
+			std::vector<std::string> columns = split(split_perft[i], " ");
+			PerftStats expected{std::stoull(columns[2]), std::stoull(columns[3]), std::stoull(columns[4]),
+								std::stoull(columns[5]), std::stoull(columns[6]), std::stoull(columns[7]),
+								std::stoull(columns[8]), std::stoull(columns[9]), std::stoull(columns[10])};
+
+			PerftStats actual;
+			if (p.turn() == WHITE) perft_stats<WHITE>(p, static_cast<i32>(i), actual);
+			else perft_stats<BLACK>(p, static_cast<i32>(i), actual);
+			CHECK_EQ(actual, expected);
+		}
+	}
+}
+
+TEST_CASE("perft-histograms") {
+	// Checked against the node and check counts of tests/perft_stats.txt.
+	std::ifstream input_file("./tests/perft_stats.txt");
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		std::vector<std::string> split_perft = split(input_line, ";");
+		Position p(split_perft[0]);
+		const i32 depth = 3;
+		PerftHistograms histograms(depth);
+		const u64 nodes = p.turn() == WHITE ? perft_histograms<WHITE>(p, depth, histograms) :
+						  perft_histograms<BLACK>(p, depth, histograms);
+		CHECK_EQ(nodes, std::stoull(split(split_perft[depth], " ")[2]));
+
+		for (usize ply = 0; ply < depth; ply++) {
+			const PlyHistogram& h = histograms.plies[ply];
+			// The nodes at a ply are the leaves of a perft to that depth.
+			if (ply > 0) {
+				const std::vector<std::string> columns = split(split_perft[ply], " ");
+				CHECK_EQ(h.nodes(), std::stoull(columns[2]));
+				CHECK_EQ(h.checkers[1] + h.checkers[2], std::stoull(columns[7]));
+				CHECK_EQ(h.checkers[2], std::stoull(columns[9]));
+			}
+
+			u64 children = 0;
+			for (usize moves = 0; moves < h.moves.size(); moves++) children += moves * h.moves[moves];
+			CHECK_EQ(children, ply + 1 < depth ? histograms.plies[ply + 1].nodes() : nodes);
+		}
+	}
+}
+
 TEST_CASE("perft-all-bulk") {
 	std::string perft_file_path = "./tests/perft_results.txt";
 	std::ifstream input_file(perft_file_path);
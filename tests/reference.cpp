@@ -0,0 +1,73 @@
+#include "lib/doctests.h"
+#include "../src/board/position.h"
+#include "../src/move_gen/move_generator.h"
+#include "../src/move_gen/reference_generator.h"
+#include "../src/utils/helpers.h"
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace {
+	std::vector<u16> sorted_moves(const std::vector<Move>& moves) {
+		std::vector<u16> raw;
+		for (Move move : moves) raw.push_back(move.raw());
+		std::sort(raw.begin(), raw.end());
+		return raw;
+	}
+
+	template<Color Us>
+	void check_against_reference(Position& p, i32 depth) {
+		MoveList<Us, ALL> list(p);
+		const std::vector<Move> moves(list.begin(), list.end());
+		REQUIRE_EQ(sorted_moves(moves), sorted_moves(reference::legal_moves<Us>(p)));
+
+		if (depth == 0) return;
+		for (Move move : moves) {
+			p.play<Us>(move);
+			check_against_reference<~Us>(p, depth - 1);
+			p.undo<Us>(move);
+		}
+	}
+
+	u64 reference_perft(Position& p, i32 depth) {
+		const std::vector<Move> moves = reference::legal_moves(p);
+		if (depth == 1) return moves.size();
+		u64 nodes = 0;
+		for (Move move : moves) {
+			if (p.turn() == WHITE) {
+				p.play<WHITE>(move);
+				nodes += reference_perft(p, depth - 1);
+				p.undo<WHITE>(move);
+			} else {
+				p.play<BLACK>(move);
+				nodes += reference_perft(p, depth - 1);
+				p.undo<BLACK>(move);
+			}
+		}
+		return nodes;
+	}
+}
+
+TEST_SUITE_BEGIN("reference");
+
+TEST_CASE("reference-perft") {
+	std::ifstream input_file("./tests/perft_results.txt");
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		std::vector<std::string> split_perft = split(input_line, ";");
+		Position p(split_perft[0]);
+		CHECK_EQ(reference_perft(p, 2), std::stoull(split(split_perft[2], " ")[2]));
+	}
+}
+
+TEST_CASE("move-list-matches-reference") {
+	std::ifstream input_file("./tests/perft_results.txt");
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		Position p(split(input_line, ";")[0]);
+		if (p.turn() == WHITE) check_against_reference<WHITE>(p, 2);
+		else check_against_reference<BLACK>(p, 2);
+	}
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,52 @@
+#include "lib/doctests.h"
+#include "../src/board/position.h"
+#include "../src/move_gen/move_generator.h"
+#include <limits>
+
+TEST_SUITE_BEGIN("scored-moves");
+
+TEST_CASE("scored-move-packing") {
+	Move m = Move(e7, e8, PR_QUEEN | CAPTURE_TYPE);
+	for (MoveScore score : {MoveScore(-32768), MoveScore(-1), MoveScore(0), MoveScore(1), MoveScore(32767)}) {
+		ScoredMove entry(m, score);
+		CHECK(entry.move() == m);
+		CHECK_EQ(entry.score(), score);
+	}
+	CHECK_EQ(ScoredMove(m).score(), 0);
+	CHECK_LT(ScoredMove(m, -5).raw(), ScoredMove(m, 3).raw());
+}
+
+TEST_CASE("scored-move-list-matches-move-list") {
+	Position p(KIWIPETE_FEN);
+	MoveList<WHITE, ALL> list(p);
+	ScoredMoveList<WHITE, ALL> scored(p);
+
+	REQUIRE_EQ(list.size(), scored.size());
+	for (usize i = 0; i < list.size(); i++) CHECK(list[i] == scored[i].move());
+}
+
+TEST_CASE("pick-best") {
+	Position p(KIWIPETE_FEN);
+	ScoredMoveList<WHITE, ALL> scored(p);
+
+	// Captures first, then everything else ordered by destination square.
+	auto scorer = [](Move m) { return static_cast<MoveScore>(m.is_capture() ? 1000 + m.to() : -m.to()); };
+	scored.score(scorer);
+
+	MoveScore previous = std::numeric_limits<MoveScore>::max();
+	for (usize i = 0; i < scored.size(); i++) {
+		Move best = scored.pick_best(i);
+		CHECK_LE(scorer(best), previous);
+		previous = scorer(best);
+	}
+	CHECK(scored.pick_best(scored.size()) == Move());
+	CHECK(scored.pick_best(scored.size() + 1) == Move());
+
+	// Fool's mate, no moves to pick from.
+	Position mated("rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3");
+	ScoredMoveList<WHITE, ALL> empty(mated);
+	REQUIRE_EQ(empty.size(), 0);
+	CHECK(empty.pick_best(0) == Move());
+}
+
+TEST_SUITE_END();
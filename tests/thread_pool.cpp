@@ -0,0 +1,172 @@
+#include "lib/doctests.h"
+#include "../src/board/position.h"
+#include "../src/move_gen/parallel.h"
+#include "../src/move_gen/perft.h"
+#include "../src/move_gen/profile.h"
+#include "../src/utils/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_SUITE_BEGIN("thread-pool");
+
+TEST_CASE("work-stealing-deque") {
+	constexpr usize ITEMS = 200000, THIEVES = 3;
+	// Starts small so the buffer grows while thieves read it.
+	WorkStealingDeque<usize*> deque(2);
+	std::vector<usize> items(ITEMS);
+	std::vector<std::atomic<u32>> taken(ITEMS);
+	std::atomic<bool> done{false};
+
+	std::vector<std::thread> thieves;
+	for (usize t = 0; t < THIEVES; t++) {
+		thieves.emplace_back([&]() {
+			usize* item;
+			while (!done) {
+				if (deque.steal(item)) taken[static_cast<usize>(item - items.data())]++;
+			}
+		});
+	}
+	usize* item;
+	for (usize i = 0; i < ITEMS; i++) {
+		deque.push(&items[i]);
+		// Pops every third item, so the owner and the thieves race for the last ones.
+		if (i % 3 == 0 && deque.pop(item)) taken[static_cast<usize>(item - items.data())]++;
+	}
+	while (deque.pop(item)) taken[static_cast<usize>(item - items.data())]++;
+	done = true;
+	for (std::thread& thief : thieves) thief.join();
+
+	CHECK(deque.empty());
+	CHECK(std::all_of(taken.begin(), taken.end(), [](const std::atomic<u32>& count) { return count == 1; }));
+}
+
+TEST_CASE("thread-pool-parallel-for") {
+	for (usize threads : {1, 3, 8}) {
+		ThreadPool pool(threads);
+		CHECK_EQ(pool.size(), threads);
+		CHECK_EQ(pool.thread_index(), threads);
+		for (usize count : {0, 1, 7, 10000}) {
+			std::vector<std::atomic<u32>> visits(count);
+			std::atomic<bool> on_workers{true};
+			parallel_for(pool, count, [&](usize i) {
+				visits[i]++;
+				if (pool.thread_index() >= pool.size()) on_workers = false;
+			});
+			CHECK(std::all_of(visits.begin(), visits.end(), [](const std::atomic<u32>& v) { return v == 1; }));
+			CHECK(on_workers);
+		}
+	}
+}
+
+// Sum of [begin, end) by splitting in halves, each half waiting on a group of its own.
+u64 nested_sum(ThreadPool& pool, u64 begin, u64 end) {
+	if (end - begin <= 8) {
+		u64 sum = 0;
+		for (u64 i = begin; i < end; i++) sum += i;
+		return sum;
+	}
+	const u64 middle = begin + (end - begin) / 2;
+	u64 left = 0, right = 0;
+	TaskGroup group(pool);
+	group.run([&]() { left = nested_sum(pool, begin, middle); });
+	group.run([&]() { right = nested_sum(pool, middle, end); });
+	group.wait();
+	return left + right;
+}
+
+TEST_CASE("thread-pool-nested-groups") {
+	ThreadPool pool(4);
+	u64 sum = 0;
+	TaskGroup group(pool);
+	group.run([&]() { sum = nested_sum(pool, 0, 100000); });
+	group.wait();
+	CHECK_EQ(sum, 100000ULL * 99999 / 2);
+
+	// Groups used from several threads outside the pool at once.
+	std::vector<u64> sums(4);
+	std::vector<std::atomic<u64>> visits(sums.size());
+	std::vector<std::thread> callers;
+	for (usize t = 0; t < sums.size(); t++) {
+		callers.emplace_back([&, t]() {
+			parallel_for(pool, 1000, [&](usize) { visits[t]++; });
+			TaskGroup caller_group(pool);
+			caller_group.run([&, t]() { sums[t] = nested_sum(pool, 0, 1000); });
+			caller_group.wait();
+		});
+	}
+	for (std::thread& caller : callers) caller.join();
+	CHECK(std::all_of(sums.begin(), sums.end(), [](u64 s) { return s == 1000ULL * 999 / 2; }));
+	CHECK(std::all_of(visits.begin(), visits.end(), [](const std::atomic<u64>& v) { return v == 1000; }));
+}
+
+TEST_CASE("thread-pool-rethrows") {
+	ThreadPool pool(3);
+	CHECK_THROWS_AS(parallel_for(pool, 1000, [](usize i) {
+		if (i == 500) throw std::runtime_error("job");
+	}), std::runtime_error);
+
+	TaskGroup group(pool);
+	group.run([]() { throw std::invalid_argument("task"); });
+	CHECK_THROWS_AS(group.wait(), std::invalid_argument);
+	// The group can be used again once the exception is rethrown.
+	std::atomic<u32> runs{0};
+	for (i32 i = 0; i < 10; i++) group.run([&]() { runs++; });
+	group.wait();
+	CHECK_EQ(runs, 10);
+}
+
+TEST_CASE("parallel-divide-matches-perft") {
+	ThreadPool pool(3);
+	Position start(START_FEN);
+	Position kiwipete("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+	for (i32 split_depth : {1, 3}) {
+		std::vector<u64> nodes = parallel_divide<WHITE>(pool, start, 5, split_depth);
+		CHECK_EQ(nodes.size(), 20);
+		CHECK_EQ(std::accumulate(nodes.begin(), nodes.end(), 0ULL), 4865609);
+		nodes = parallel_divide<WHITE>(pool, kiwipete, 3, split_depth);
+		CHECK_EQ(std::accumulate(nodes.begin(), nodes.end(), 0ULL), 97862);
+	}
+	const std::vector<u64> leaves = parallel_divide<WHITE>(pool, start, 1);
+	CHECK(std::all_of(leaves.begin(), leaves.end(), [](u64 n) { return n == 1; }));
+	CHECK_EQ(start.fen(), Position(START_FEN).fen());
+}
+
+// Phase counters of workers that are still alive are part of the collected counters, so a pooled run reports what a
+// single threaded one does.
+TEST_CASE("thread-pool-profile-counters") {
+	ThreadPool pool(3);
+	profile::reset();
+	parallel_for(pool, 1000, [](usize) { profile::thread_counters.counters.calls[PHASE_PAWNS]++; });
+	CHECK_EQ(profile::collect().calls[PHASE_PAWNS], 1000);
+
+	Position start(START_FEN);
+	std::vector<Move> root_moves;
+	for (Move move : MoveList<WHITE, ALL>(start)) root_moves.push_back(move);
+	auto perft_below = [&](usize i) {
+		Position p(START_FEN);
+		p.play<WHITE>(root_moves[i]);
+		return perft<BLACK>(p, 3);
+	};
+
+	profile::reset();
+	u64 serial_nodes = 0;
+	for (usize i = 0; i < root_moves.size(); i++) serial_nodes += perft_below(i);
+	const profile::PhaseCounters serial = profile::collect();
+
+	profile::reset();
+	std::atomic<u64> pooled_nodes{0};
+	parallel_for(pool, root_moves.size(), [&](usize i) { pooled_nodes += perft_below(i); });
+	const profile::PhaseCounters pooled = profile::collect();
+
+	CHECK_EQ(pooled_nodes, serial_nodes);
+	CHECK_EQ(pooled.calls, serial.calls);
+	CHECK_EQ(pooled.moves, serial.moves);
+	if constexpr (MOVEGEN_PROFILE) CHECK_GT(pooled.calls[PHASE_GENERATE], 0);
+	profile::reset();
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,89 @@
+#include "lib/doctests.h"
+#include "../src/board/position.h"
+#include "../src/move_gen/move_generator.h"
+#include <algorithm>
+#include <vector>
+
+TEST_SUITE_BEGIN("visitor");
+
+struct MoveCounter {
+	u64 count = 0;
+	void visit(Square, Bitboard to, MoveType type) {
+		count += pop_count(to) * (type & PROMOTION_TYPE ? 4 : 1);
+	}
+};
+
+template<Color Us>
+u64 visitor_perft(Position& p, i32 depth) {
+	if (depth == 1) {
+		MoveCounter counter;
+		generate<Us>(p, counter);
+		return counter.count;
+	}
+
+	u64 nodes = 0;
+	MoveList<Us, ALL> list(p);
+	for (Move move : list) {
+		p.play<Us>(move);
+		nodes += visitor_perft<~Us>(p, depth - 1);
+		p.undo<Us>(move);
+	}
+	return nodes;
+}
+
+TEST_CASE("move-visitor-matches-move-list") {
+	for (const std::string& fen : {START_FEN, KIWIPETE_FEN, TALKCHESS_FEN}) {
+		Position p(fen);
+		std::vector<Move> visited;
+		generate<WHITE>(p, [&](Move m) { visited.push_back(m); });
+
+		MoveList<WHITE, ALL> list(p);
+		REQUIRE_EQ(visited.size(), list.size());
+		for (usize i = 0; i < list.size(); i++) CHECK(visited[i] == list[i]);
+	}
+}
+
+TEST_CASE("bitboard-visitor-perft") {
+	Position start(START_FEN);
+	CHECK_EQ(visitor_perft<WHITE>(start, 4), 197281);
+
+	Position kiwipete(KIWIPETE_FEN);
+	CHECK_EQ(visitor_perft<WHITE>(kiwipete, 3), 97862);
+
+	Position talkchess(TALKCHESS_FEN);
+	CHECK_EQ(visitor_perft<WHITE>(talkchess, 3), 62379);
+}
+
+TEST_CASE("bitboard-visitor-captures") {
+	Position p(KIWIPETE_FEN);
+	MoveCounter counter;
+	generate<WHITE, CAPTURES>(p, counter);
+	CHECK_EQ(counter.count, MoveList<WHITE, CAPTURES>(p).size());
+}
+
+// One visit with one target, promotions as queen promotions.
+TEST_CASE("bitboard-visitor-any") {
+	struct Recorder {
+		std::vector<std::pair<Bitboard, MoveType>> visits;
+		void visit(Square, Bitboard to, MoveType type) { visits.emplace_back(to, type); }
+	};
+
+	Position kiwipete(KIWIPETE_FEN);
+	Recorder recorder;
+	generate<WHITE, ANY>(kiwipete, recorder);
+	REQUIRE_EQ(recorder.visits.size(), 1);
+	CHECK_EQ(pop_count(recorder.visits[0].first), 1);
+
+	// The king is boxed in, only the pawn on b7 can move and every move of it promotes.
+	Position promotions("n1n4k/1P6/8/8/8/8/5q2/7K w - - 0 1");
+	MoveList<WHITE, ALL> moves(promotions);
+	REQUIRE_GT(moves.size(), 0);
+	REQUIRE(std::all_of(moves.begin(), moves.end(), [](Move m) { return m.is_promotion(); }));
+	recorder.visits.clear();
+	generate<WHITE, ANY>(promotions, recorder);
+	REQUIRE_EQ(recorder.visits.size(), 1);
+	CHECK_EQ(pop_count(recorder.visits[0].first), 1);
+	CHECK_EQ(recorder.visits[0].second & ~CAPTURE_TYPE, PR_QUEEN);
+}
+
+TEST_SUITE_END();
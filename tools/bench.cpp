@@ -0,0 +1,322 @@
+// Fixed workload benchmarks with machine-readable results and regression gating.
+// Usage: bench [--repetitions N] [--warmup N] [--corpus perft results file] [--json out file]
+//              [--baseline json file] [--threshold percent] [--counters]
+// --corpus also takes FEN files and binary corpora written by the corpus tool, see tools/corpus.cpp.
+// --counters adds hardware performance counters per item, see src/utils/perf_counters.h.
+// Builds with MIDNIGHT_MOVEGEN_PROFILE also report the generator phase counters of every workload.
+#include "../src/board/packed_position.h"
+#include "../src/board/position.h"
+#include "../src/move_gen/move_generator.h"
+#include "../src/move_gen/perft.h"
+#include "../src/utils/helpers.h"
+#include "../src/utils/perf_counters.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// Results are folded into the sink so the compiler cannot drop the measured work.
+volatile u64 sink = 0;
+void consume(u64 value) { sink = sink ^ value; }
+
+// Workloads shorter than a few milliseconds are repeated, so timer resolution and scheduling noise matter less.
+constexpr usize SMALL_PASSES = 100;
+
+struct Workload {
+	string name;
+	string unit;
+	// Runs the workload once and returns the number of items processed.
+	std::function<u64()> run;
+};
+
+struct Result {
+	string name;
+	string unit;
+	u64 items = 0;
+	usize repetitions = 0;
+	double median = 0;
+	double mean = 0;
+	double stddev = 0;
+	double min = 0;
+	double max = 0;
+	// Hardware counter totals over all repetitions, divided by the items processed.
+	std::vector<std::pair<const char*, double>> counters;
+};
+
+template<Color Us>
+void collect_positions(Position& p, i32 depth, std::vector<Position>& positions) {
+	positions.push_back(p);
+	if (depth == 0) return;
+	for (Move move : MoveList<Us, ALL>(p)) {
+		p.play<Us>(move);
+		collect_positions<~Us>(p, depth - 1, positions);
+		p.undo<Us>(move);
+	}
+}
+
+template<Color Us>
+u64 generate_moves(Position& p) {
+	MoveList<Us, ALL> list(p);
+	return list.size();
+}
+
+template<Color Us>
+u64 make_unmake(Position& p) {
+	MoveList<Us, ALL> list(p);
+	for (Move move : list) {
+		p.play<Us>(move);
+		consume(p.hash());
+		p.undo<Us>(move);
+	}
+	return list.size();
+}
+
+template<Color Us>
+u64 perft_position(const string& fen, i32 depth) {
+	Position p(fen);
+	return perft<Us>(p, depth);
+}
+
+std::vector<Workload> workloads(const std::vector<string>& fens) {
+	// The corpus is every position of the results file and its children, about 1700 positions.
+	auto positions = std::make_shared<std::vector<Position>>();
+	for (const string& fen : fens) {
+		Position p(fen);
+		if (p.turn() == WHITE) collect_positions<WHITE>(p, 1, *positions);
+		else collect_positions<BLACK>(p, 1, *positions);
+	}
+
+	// Fixed pseudo random squares and occupancies, the same for every run.
+	auto lookups = std::make_shared<std::vector<std::pair<Square, Bitboard>>>();
+	u64 state = 0x9E3779B97F4A7C15ULL;
+	for (usize i = 0; i < 1 << 16; i++) {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		const Bitboard occupancy = state & (state >> 11) & (state >> 23);
+		lookups->push_back({static_cast<Square>(state >> 58), occupancy});
+	}
+
+	return {
+		{"movegen", "positions/s", [positions]() {
+			u64 moves = 0;
+			for (usize pass = 0; pass < SMALL_PASSES; pass++) {
+				for (Position& p : *positions) moves += p.turn() == WHITE ? generate_moves<WHITE>(p) : generate_moves<BLACK>(p);
+			}
+			consume(moves);
+			return static_cast<u64>(positions->size() * SMALL_PASSES);
+		}},
+		{"make-unmake", "moves/s", [positions]() {
+			u64 moves = 0;
+			for (usize pass = 0; pass < SMALL_PASSES / 10; pass++) {
+				for (Position& p : *positions) moves += p.turn() == WHITE ? make_unmake<WHITE>(p) : make_unmake<BLACK>(p);
+			}
+			return moves;
+		}},
+		{"perft-startpos-5", "nodes/s", []() { return perft_position<WHITE>(START_FEN, 5); }},
+		{"perft-kiwipete-4", "nodes/s", []() { return perft_position<WHITE>(KIWIPETE_FEN, 4); }},
+		{"fen-parse", "positions/s", [fens]() {
+			for (usize pass = 0; pass < SMALL_PASSES / 10; pass++) {
+				for (const string& fen : fens) consume(Position(fen).hash());
+			}
+			return static_cast<u64>(fens.size() * (SMALL_PASSES / 10));
+		}},
+		{"attacks", "lookups/s", [lookups]() {
+			Bitboard attacks = 0;
+			for (usize pass = 0; pass < SMALL_PASSES; pass++) {
+				for (auto [square, occupancy] : *lookups) {
+					attacks ^= tables::attacks<ROOK>(square, occupancy) ^ tables::attacks<BISHOP>(square, occupancy);
+				}
+			}
+			consume(attacks);
+			return static_cast<u64>(lookups->size() * 2 * SMALL_PASSES);
+		}},
+	};
+}
+
+Result measure(const Workload& workload, usize warmup, usize repetitions, PerfCounterSet* counters) {
+	for (usize i = 0; i < warmup; i++) workload.run();
+	profile::reset();
+
+	Result result;
+	result.name = workload.name;
+	result.unit = workload.unit;
+	std::vector<double> throughputs;
+	if (counters) counters->start();
+	for (usize i = 0; i < repetitions; i++) {
+		const auto start_time = std::chrono::steady_clock::now();
+		result.items = workload.run();
+		const auto end_time = std::chrono::steady_clock::now();
+		const double seconds = std::chrono::duration<double>(end_time - start_time).count();
+		throughputs.push_back(static_cast<double>(result.items) / std::max(seconds, 1e-9));
+	}
+	if (counters) {
+		counters->stop();
+		for (const auto& [name, count] : counters->read()) {
+			result.counters.emplace_back(name, static_cast<double>(count) / static_cast<double>(result.items * repetitions));
+		}
+	}
+
+	std::sort(throughputs.begin(), throughputs.end());
+	const usize n = throughputs.size();
+	result.repetitions = n;
+	result.median = n % 2 ? throughputs[n / 2] : (throughputs[n / 2 - 1] + throughputs[n / 2]) / 2;
+	for (double t : throughputs) result.mean += t / static_cast<double>(n);
+	for (double t : throughputs) result.stddev += (t - result.mean) * (t - result.mean) / static_cast<double>(n);
+	result.stddev = std::sqrt(result.stddev);
+	result.min = throughputs.front();
+	result.max = throughputs.back();
+	return result;
+}
+
+// One benchmark object per line, which keeps the baseline readable without a JSON parser.
+void write_json(std::ostream& os, const std::vector<Result>& results) {
+	os << std::fixed << std::setprecision(1);
+	os << "{\n  \"benchmarks\": [\n";
+	for (usize i = 0; i < results.size(); i++) {
+		const Result& r = results[i];
+		os << "    {\"name\": \"" << r.name << "\", \"unit\": \"" << r.unit << "\", \"items\": " << r.items
+		   << ", \"repetitions\": " << r.repetitions << ", \"median\": " << r.median << ", \"mean\": " << r.mean
+		   << ", \"stddev\": " << r.stddev << ", \"min\": " << r.min << ", \"max\": " << r.max;
+		if (!r.counters.empty()) {
+			os << std::setprecision(4) << ", \"counters\": {";
+			for (usize c = 0; c < r.counters.size(); c++) {
+				os << (c ? ", \"" : "\"") << r.counters[c].first << "\": " << r.counters[c].second;
+			}
+			os << "}" << std::setprecision(1);
+		}
+		os << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	os << "  ]\n}\n";
+}
+
+// Reads the median of every benchmark from a file written by write_json.
+std::vector<std::pair<string, double>> read_baseline(std::istream& is) {
+	std::vector<std::pair<string, double>> medians;
+	std::string line;
+	while (std::getline(is, line)) {
+		const usize name = line.find("\"name\": \"");
+		const usize median = line.find("\"median\": ");
+		if (name == string::npos || median == string::npos) continue;
+		const usize name_start = name + 9;
+		medians.emplace_back(line.substr(name_start, line.find('"', name_start) - name_start),
+							 std::stod(line.substr(median + 10)));
+	}
+	return medians;
+}
+
+int MIDNIGHT_MAIN(int argc, char* argv[]) {
+	usize repetitions = 10;
+	usize warmup = 2;
+	double threshold = 5;
+	string corpus_path = "./tests/perft_results.txt";
+	string json_path;
+	string baseline_path;
+	bool use_counters = false;
+
+	bool valid = true;
+	for (int i = 1; i < argc && valid; i++) {
+		const string option = argv[i];
+		if (option == "--counters") {
+			use_counters = true;
+			continue;
+		}
+		valid = i + 1 < argc;
+		if (!valid) break;
+		const string value = argv[++i];
+		try {
+			if (option == "--repetitions") repetitions = std::stoul(value);
+			else if (option == "--warmup") warmup = std::stoul(value);
+			else if (option == "--threshold") threshold = std::stod(value);
+			else if (option == "--corpus") corpus_path = value;
+			else if (option == "--json") json_path = value;
+			else if (option == "--baseline") baseline_path = value;
+			else throw std::invalid_argument(option);
+		} catch (const std::exception&) {
+			std::cerr << "Invalid option " << option << " " << value << std::endl;
+			return 1;
+		}
+	}
+	if (!valid || repetitions < 1) {
+		std::cerr << "Usage: " << argv[0] << " [--repetitions N] [--warmup N] [--corpus perft results file]"
+				  << " [--json out file] [--baseline json file] [--threshold percent] [--counters]" << std::endl;
+		return 1;
+	}
+
+	// A perft results file, a FEN per line, or PackedPosition records from the corpus tool in a .bin file.
+	std::vector<string> fens;
+	std::ifstream corpus(corpus_path, std::ios::binary);
+	if (corpus_path.ends_with(".bin")) {
+		for (const PackedPosition& packed : read_packed(corpus)) fens.push_back(packed.fen());
+	} else {
+		std::string input_line;
+		while (std::getline(corpus, input_line)) fens.push_back(split(input_line, ";")[0]);
+	}
+	if (fens.empty()) {
+		std::cerr << "Cannot read positions from " << corpus_path << std::endl;
+		return 1;
+	}
+
+	std::optional<PerfCounterSet> counters;
+	if (use_counters) {
+		counters.emplace();
+		if (!counters->available()) {
+			std::cerr << "Hardware counters unavailable (no PMU access or perf_event_paranoid too high)" << std::endl;
+			counters.reset();
+		}
+	}
+
+	// With the JSON on stdout the text goes to stderr, so stdout stays valid JSON.
+	std::ostream& text = json_path == "-" ? std::cerr : std::cout;
+	std::vector<Result> results;
+	for (const Workload& workload : workloads(fens)) {
+		results.push_back(measure(workload, warmup, repetitions, counters ? &*counters : nullptr));
+		const Result& r = results.back();
+		text << std::left << std::setw(20) << r.name << std::right << std::fixed << std::setprecision(0)
+				  << std::setw(16) << r.median << " " << std::left << std::setw(12) << r.unit << std::right
+				  << std::setprecision(1) << " +- " << 100 * r.stddev / r.mean << "%" << std::endl;
+		for (const auto& [name, per_item] : r.counters) {
+			text << "    " << std::left << std::setw(24) << name << std::right << std::setprecision(3)
+					  << std::setw(12) << per_item << std::endl;
+		}
+		if constexpr (MOVEGEN_PROFILE) profile::report(text);
+	}
+
+	if (json_path == "-") write_json(std::cout, results);
+	else if (!json_path.empty()) {
+		std::ofstream json_file(json_path);
+		write_json(json_file, results);
+	}
+
+	if (baseline_path.empty()) return 0;
+	std::ifstream baseline_file(baseline_path);
+	if (!baseline_file) {
+		std::cerr << "Cannot open " << baseline_path << std::endl;
+		return 1;
+	}
+
+	// Fails when the median throughput of any benchmark dropped by more than the threshold.
+	usize regressions = 0;
+	text << std::endl;
+	for (const auto& [name, baseline_median] : read_baseline(baseline_file)) {
+		auto current = std::find_if(results.begin(), results.end(), [&](const Result& r) { return r.name == name; });
+		if (current == results.end()) continue;
+		const double change = 100 * (current->median / baseline_median - 1);
+		const bool regressed = change < -threshold;
+		regressions += regressed;
+		text << std::left << std::setw(20) << name << std::right << std::showpos << std::setprecision(1)
+				  << std::setw(8) << change << "%" << std::noshowpos << (regressed ? "  REGRESSION" : "") << std::endl;
+	}
+	return regressions ? 2 : 0;
+}
+
+MIDNIGHT_NAMESPACE_END
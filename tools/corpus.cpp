@@ -0,0 +1,168 @@
+// Random playout corpus generator: every position is reached by uniformly random legal moves from the start position,
+// stopping at a ply drawn from [--min-ply, --max-ply], and is kept when it passes the filters.
+// Usage: corpus [--count N] [--seed N] [--threads N] [--min-ply N] [--max-ply N] [--min-pieces N] [--max-pieces N]
+//               [--min-material N] [--max-material N] [--no-check] [--start fen] [--format fen|binary] [--out file]
+// Material is counted for both sides in pawns, 1 per pawn, 3 per knight and bishop, 5 per rook and 9 per queen, 78 in
+// the start position.
+// Position i depends only on the seed and i, so the output is the same for any number of threads.
+// FEN output is one position per line and can be passed to the bench tool with --corpus, binary output is a
+// sequence of PackedPosition records, see src/board/packed_position.h.
+#include "../src/board/packed_position.h"
+#include "../src/board/position.h"
+#include "../src/move_gen/move_generator.h"
+#include "../src/utils/helpers.h"
+#include "../src/utils/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <vector>
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+struct Options {
+	u64 count = 100000;
+	u64 seed = 1;
+	usize threads = default_thread_count();
+	i32 min_ply = 16;
+	i32 max_ply = 80;
+	u32 min_pieces = 2;
+	u32 max_pieces = 32;
+	u32 min_material = 0;
+	u32 max_material = std::numeric_limits<u32>::max();
+	bool no_check = false;
+	string start = START_FEN;
+	bool binary = false;
+	string out;
+};
+
+// Longest playout, the state history of a Position holds the initial state and one per move played.
+constexpr i32 MAX_PLY = Position::POSITION_STATE_SIZE - 2;
+// A playout that ends early or lands on a filtered position is retried, up to this many times per position.
+constexpr u32 MAX_ATTEMPTS = 1000;
+// Positions are generated in batches and written in order.
+constexpr u64 BATCH_SIZE = 1 << 14;
+
+template<Color Us>
+bool play_random(Position& p, u64& rng) {
+	MoveList<Us, ALL> list(p);
+	if (list.size() == 0) return false;
+	p.play<Us>(*(list.begin() + splitmix64(rng) % list.size()));
+	return true;
+}
+
+u32 material(const Position& p) {
+	return pop_count(p.occupancy<WHITE, PAWN>() | p.occupancy<BLACK, PAWN>()) +
+		   3 * pop_count(p.occupancy<WHITE, KNIGHT>() | p.occupancy<BLACK, KNIGHT>() |
+						 p.occupancy<WHITE, BISHOP>() | p.occupancy<BLACK, BISHOP>()) +
+		   5 * pop_count(p.occupancy<WHITE, ROOK>() | p.occupancy<BLACK, ROOK>()) +
+		   9 * pop_count(p.occupancy<WHITE, QUEEN>() | p.occupancy<BLACK, QUEEN>());
+}
+
+// Games that end before the target ply, and positions without legal moves, are not kept.
+bool accept(Position& p, const Options& options) {
+	const u32 pieces = pop_count(p.occupancy());
+	if (pieces < options.min_pieces || pieces > options.max_pieces) return false;
+	const u32 value = material(p);
+	if (value < options.min_material || value > options.max_material) return false;
+	if (options.no_check && p.in_check()) return false;
+	return !p.has_insufficient_material() && p.has_legal_move();
+}
+
+std::optional<PackedPosition> generate(const Position& start, u64 index, const Options& options) {
+	u64 rng = options.seed ^ (index * 0xD1B54A32D192ED03ULL);
+	for (u32 attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+		Position p = start;
+		const i32 plies = options.min_ply + static_cast<i32>(splitmix64(rng) % (options.max_ply - options.min_ply + 1));
+		bool ended = false;
+		for (i32 ply = 0; ply < plies && !ended; ply++) {
+			ended = p.has_insufficient_material() || !(p.turn() == WHITE ? play_random<WHITE>(p, rng) : play_random<BLACK>(p, rng));
+		}
+		if (ended || !accept(p, options)) continue;
+
+		return PackedPosition(p);
+	}
+	return std::nullopt;
+}
+
+int MIDNIGHT_MAIN(int argc, char* argv[]) {
+	Options options;
+	bool valid = true;
+	for (int i = 1; i < argc && valid; i++) {
+		const string option = argv[i];
+		if (option == "--no-check") {
+			options.no_check = true;
+			continue;
+		}
+		valid = i + 1 < argc;
+		if (!valid) break;
+		const string value = argv[++i];
+		try {
+			if (option == "--count") options.count = std::stoull(value);
+			else if (option == "--seed") options.seed = std::stoull(value);
+			else if (option == "--threads") options.threads = parse_thread_count(value);
+			else if (option == "--min-ply") options.min_ply = std::stoi(value);
+			else if (option == "--max-ply") options.max_ply = std::stoi(value);
+			else if (option == "--min-pieces") options.min_pieces = std::stoul(value);
+			else if (option == "--max-pieces") options.max_pieces = std::stoul(value);
+			else if (option == "--min-material") options.min_material = std::stoul(value);
+			else if (option == "--max-material") options.max_material = std::stoul(value);
+			else if (option == "--start") options.start = value;
+			else if (option == "--out") options.out = value;
+			else if (option == "--format" && (value == "fen" || value == "binary")) options.binary = value == "binary";
+			else throw std::invalid_argument(option);
+		} catch (const std::exception&) {
+			std::cerr << "Invalid option " << option << " " << value << std::endl;
+			return 1;
+		}
+	}
+	if (!valid || options.threads < 1 || options.min_ply < 0 ||
+		options.min_ply > options.max_ply || options.max_ply > MAX_PLY) {
+		std::cerr << "Usage: " << argv[0] << " [--count N] [--seed N] [--threads N] [--min-ply N] [--max-ply N]"
+				  << " [--min-pieces N] [--max-pieces N] [--min-material N] [--max-material N] [--no-check] [--start fen]"
+				  << " [--format fen|binary] [--out file]"
+				  << std::endl;
+		return 1;
+	}
+
+	std::ofstream out_file;
+	if (!options.out.empty()) {
+		out_file.open(options.out, std::ios::binary);
+		if (!out_file) {
+			std::cerr << "Cannot open " << options.out << std::endl;
+			return 1;
+		}
+	}
+	std::ostream& out = options.out.empty() ? std::cout : out_file;
+	const Position start(options.start);
+
+	u64 written = 0, skipped = 0;
+	const auto start_time = std::chrono::steady_clock::now();
+	std::vector<std::optional<PackedPosition>> batch;
+	ThreadPool pool(options.threads);
+	for (u64 first = 0; first < options.count; first += BATCH_SIZE) {
+		batch.assign(std::min(BATCH_SIZE, options.count - first), std::nullopt);
+		parallel_for(pool, batch.size(), [&](usize i) { batch[i] = generate(start, first + i, options); });
+
+		for (const std::optional<PackedPosition>& position : batch) {
+			if (!position) {
+				skipped++;
+				continue;
+			}
+			if (options.binary) write_packed(out, *position);
+			else out << position->fen() << "\n";
+			written++;
+		}
+	}
+	out.flush();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	std::cerr << written << " positions in " << seconds << " s";
+	if (skipped) std::cerr << ", " << skipped << " without a position passing the filters in " << MAX_ATTEMPTS << " playouts";
+	std::cerr << std::endl;
+	return 0;
+}
+
+MIDNIGHT_NAMESPACE_END
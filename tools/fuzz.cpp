@@ -0,0 +1,332 @@
+// Differential fuzzer: plays random legal games and checks every position against the reference generator in
+// src/move_gen/reference_generator.h, the incremental hash against a fresh one, FEN round trips and play/undo.
+// The first failing position is minimized by removing pieces, castling rights and the en passant square.
+// Usage: fuzz [--seed N] [--threads N] [--seconds N] [--games N] [--first-game N] [--max-plies N] [--corpus file]
+// A failure is replayed with the seed and game it reports: fuzz --seed S --first-game G --games 1
+#include "../src/board/position.h"
+#include "../src/move_gen/move_generator.h"
+#include "../src/move_gen/reference_generator.h"
+#include "../src/utils/helpers.h"
+#include "../src/utils/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+struct Options {
+	u64 seed = 1;
+	usize threads = default_thread_count();
+	double seconds = 60;
+	// 0 runs until the time is up.
+	u64 games = 0;
+	u64 first_game = 0;
+	i32 max_plies = 300;
+	string corpus = "./tests/perft_results.txt";
+};
+
+// Longest game, the state history of a Position holds the initial state and one per move played since.
+constexpr i32 MAX_PLIES = Position::POSITION_STATE_SIZE - 1;
+
+struct Failure {
+	u64 game = 0;
+	i32 ply = 0;
+	string fen;
+	string reason;
+};
+
+void play(Position& p, Move move) {
+	if (p.turn() == WHITE) p.play<WHITE>(move);
+	else p.play<BLACK>(move);
+}
+
+// Undoes the last move, which was played by the opposite of the side now to move.
+void undo(Position& p, Move move) {
+	if (p.turn() == BLACK) p.undo<WHITE>(move);
+	else p.undo<BLACK>(move);
+}
+
+std::vector<u16> sorted_moves(const std::vector<Move>& moves) {
+	std::vector<u16> raw;
+	for (Move move : moves) raw.push_back(move.raw());
+	std::sort(raw.begin(), raw.end());
+	return raw;
+}
+
+string describe(const std::vector<u16>& moves) {
+	std::ostringstream os;
+	for (u16 raw : moves) os << " " << Move(raw);
+	return os.str();
+}
+
+template<Color Us>
+std::vector<Move> fast_moves(Position& p) {
+	MoveList<Us, ALL> list(p);
+	return {list.begin(), list.end()};
+}
+
+template<Color Us>
+std::vector<Move> fast_captures(Position& p) {
+	MoveList<Us, CAPTURES> list(p);
+	return {list.begin(), list.end()};
+}
+
+// Empty when everything agrees, otherwise what differs.
+string check_position(Position& p) {
+	const string fen = p.fen();
+	const Position fresh(fen);
+	if (fresh.fen() != fen) return "FEN round trip gives " + fresh.fen();
+	if (fresh.hash() != p.hash()) return "incremental hash differs from the hash of a fresh position";
+
+	const std::vector<Move> moves = p.turn() == WHITE ? fast_moves<WHITE>(p) : fast_moves<BLACK>(p);
+	const std::vector<u16> fast = sorted_moves(moves);
+	const std::vector<u16> expected = sorted_moves(reference::legal_moves(p));
+	if (fast != expected) {
+		std::vector<u16> missing, extra;
+		std::set_difference(expected.begin(), expected.end(), fast.begin(), fast.end(), std::back_inserter(missing));
+		std::set_difference(fast.begin(), fast.end(), expected.begin(), expected.end(), std::back_inserter(extra));
+		return "move sets differ, missing:" + describe(missing) + " extra:" + describe(extra);
+	}
+
+	std::vector<Move> captures;
+	std::copy_if(moves.begin(), moves.end(), std::back_inserter(captures), [](Move m) { return m.is_capture(); });
+	const std::vector<Move> fast_capture_list = p.turn() == WHITE ? fast_captures<WHITE>(p) : fast_captures<BLACK>(p);
+	if (sorted_moves(fast_capture_list) != sorted_moves(captures)) return "capture generation differs from all moves";
+
+	for (Move move : moves) {
+		play(p, move);
+		const bool hash_ok = Position(p.fen()).hash() == p.hash();
+		undo(p, move);
+		std::ostringstream os;
+		os << move;
+		if (!hash_ok) return "hash after " + os.str() + " differs from the hash of a fresh position";
+		if (p.fen() != fen) return "undo of " + os.str() + " gives " + p.fen();
+	}
+	return "";
+}
+
+// The four FEN fields a minimization changes, with the board expanded to one character per square from a8.
+struct FenFields {
+	string board;
+	string side;
+	string castling;
+	string en_passant;
+
+	explicit FenFields(const string& fen) {
+		std::istringstream is(fen);
+		string placement;
+		is >> placement >> side >> castling >> en_passant;
+		for (char c : placement) {
+			if (isdigit(c)) board.append(c - '0', '.');
+			else if (c != '/') board += c;
+		}
+	}
+
+	[[nodiscard]] string fen() const {
+		std::ostringstream os;
+		for (i32 rank = 0; rank < 8; rank++) {
+			i32 empty = 0;
+			for (i32 file = 0; file < 8; file++) {
+				const char c = board[rank * 8 + file];
+				if (c == '.') {
+					empty++;
+					continue;
+				}
+				if (empty) os << empty;
+				os << c;
+				empty = 0;
+			}
+			if (empty) os << empty;
+			if (rank < 7) os << '/';
+		}
+		os << " " << side << " " << (castling.empty() ? "-" : castling) << " " << en_passant << " 0 1";
+		return os.str();
+	}
+};
+
+// Rejects positions a minimization step made illegal, which would fail for reasons unrelated to the bug.
+bool plausible(const string& fen) {
+	const FenFields fields(fen);
+	if (std::count(fields.board.begin(), fields.board.end(), 'K') != 1) return false;
+	if (std::count(fields.board.begin(), fields.board.end(), 'k') != 1) return false;
+	for (i32 i = 0; i < 8; i++) {
+		if (tolower(fields.board[i]) == 'p' || tolower(fields.board[56 + i]) == 'p') return false;
+	}
+
+	const std::pair<char, std::pair<usize, usize>> rights[] = {{'K', {60, 63}}, {'Q', {60, 56}}, {'k', {4, 7}}, {'q', {4, 0}}};
+	for (const auto& [right, squares] : rights) {
+		if (fields.castling.find(right) == string::npos) continue;
+		const char king = isupper(right) ? 'K' : 'k';
+		const char rook = isupper(right) ? 'R' : 'r';
+		if (fields.board[squares.first] != king || fields.board[squares.second] != rook) return false;
+	}
+
+	Position p(fen);
+	if (fields.en_passant != "-") {
+		// The pawn that just double pushed stands in front of the en passant square, the squares behind are empty.
+		const Square ep = p.ep_square();
+		const i32 towards_pawn = p.turn() == WHITE ? -1 : 1;
+		const Piece pawn = p.piece_at(create_square(file_of(ep), Rank(rank_of(ep) + towards_pawn)));
+		if (pawn != (p.turn() == WHITE ? BLACK_PAWN : WHITE_PAWN)) return false;
+		if (p.piece_at(ep) != NO_PIECE || p.piece_at(create_square(file_of(ep), Rank(rank_of(ep) - towards_pawn))) != NO_PIECE) return false;
+	}
+	return !reference::attacked(p, reference::king_square(p, ~p.turn()), p.turn());
+}
+
+// Greedily applies simplifications that keep the position failing, until none does.
+string minimize(string fen) {
+	bool simplified = true;
+	while (simplified) {
+		simplified = false;
+		const FenFields fields(fen);
+		std::vector<string> candidates;
+
+		if (fields.en_passant != "-") {
+			FenFields candidate = fields;
+			candidate.en_passant = "-";
+			candidates.push_back(candidate.fen());
+		}
+		for (usize i = 0; i < fields.castling.size() && fields.castling != "-"; i++) {
+			FenFields candidate = fields;
+			candidate.castling.erase(i, 1);
+			candidates.push_back(candidate.fen());
+		}
+		for (usize i = 0; i < 64; i++) {
+			if (fields.board[i] == '.' || tolower(fields.board[i]) == 'k') continue;
+			FenFields candidate = fields;
+			candidate.board[i] = '.';
+			candidates.push_back(candidate.fen());
+		}
+
+		for (const string& candidate : candidates) {
+			if (!plausible(candidate)) continue;
+			Position p(candidate);
+			if (check_position(p).empty()) continue;
+			fen = candidate;
+			simplified = true;
+			break;
+		}
+	}
+	return fen;
+}
+
+// Plays one random game and checks every position of it, then undoes all moves and checks the start is restored.
+std::optional<Failure> play_game(const string& start_fen, u64 game, const Options& options, u64& plies) {
+	u64 rng = options.seed ^ (game * 0xD1B54A32D192ED03ULL);
+	Position p(start_fen);
+	const string start = p.fen();
+	const ZobristHash start_hash = p.hash();
+	std::vector<Move> played;
+
+	for (i32 ply = 0; ply < options.max_plies; ply++) {
+		plies++;
+		const string reason = check_position(p);
+		if (!reason.empty()) return Failure{game, ply, p.fen(), reason};
+
+		const std::vector<Move> moves = p.turn() == WHITE ? fast_moves<WHITE>(p) : fast_moves<BLACK>(p);
+		if (moves.empty() || p.has_insufficient_material()) break;
+		const Move move = moves[splitmix64(rng) % moves.size()];
+		play(p, move);
+		played.push_back(move);
+	}
+
+	for (auto move = played.rbegin(); move != played.rend(); move++) undo(p, *move);
+	if (p.fen() != start || p.hash() != start_hash) {
+		return Failure{game, 0, start, "undoing the game gives " + p.fen()};
+	}
+	return std::nullopt;
+}
+
+int MIDNIGHT_MAIN(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		const string option = argv[i];
+		const string value = argv[i + 1];
+		try {
+			if (option == "--seed") options.seed = std::stoull(value);
+			else if (option == "--threads") options.threads = parse_thread_count(value);
+			else if (option == "--seconds") options.seconds = std::stod(value);
+			else if (option == "--games") options.games = std::stoull(value);
+			else if (option == "--first-game") options.first_game = std::stoull(value);
+			else if (option == "--max-plies") options.max_plies = std::stoi(value);
+			else if (option == "--corpus") options.corpus = value;
+			else throw std::invalid_argument(option);
+		} catch (const std::exception&) {
+			std::cerr << "Invalid option " << option << " " << value << std::endl;
+			return 1;
+		}
+	}
+	if (argc % 2 == 0 || options.threads < 1 || options.max_plies > MAX_PLIES) {
+		std::cerr << "Usage: " << argv[0] << " [--seed N] [--threads N] [--seconds N] [--games N] [--first-game N]"
+				  << " [--max-plies N] [--corpus file]" << std::endl;
+		return 1;
+	}
+
+	// Games start from the start position and every position of the corpus in turn.
+	std::vector<string> start_fens = {START_FEN};
+	std::ifstream corpus(options.corpus);
+	std::string input_line;
+	while (std::getline(corpus, input_line)) start_fens.push_back(split(input_line, ";")[0]);
+
+	const u64 last_game = options.games ? options.first_game + options.games : ~0ULL;
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(options.seconds);
+	std::atomic<u64> next_game{options.first_game};
+	std::atomic<u64> games_done{0}, plies_done{0};
+	std::atomic<bool> stop{false};
+	std::mutex failure_mutex;
+	std::optional<Failure> failure;
+
+	const auto start_time = std::chrono::steady_clock::now();
+	// One task per thread, each playing games until they run out or the time is up.
+	ThreadPool pool(options.threads);
+	TaskGroup games(pool);
+	for (usize t = 0; t < options.threads; t++) {
+		games.run([&]() {
+			for (u64 game = next_game++; game < last_game && !stop; game = next_game++) {
+				u64 plies = 0;
+				std::optional<Failure> result = play_game(start_fens[game % start_fens.size()], game, options, plies);
+				plies_done += plies;
+				games_done++;
+				if (result) {
+					std::lock_guard<std::mutex> lock(failure_mutex);
+					if (!failure || result->game < failure->game) failure = result;
+					stop = true;
+				}
+				if (!options.games && std::chrono::steady_clock::now() > deadline) stop = true;
+			}
+		});
+	}
+
+	auto last_report = start_time;
+	while (!games.done()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		if (std::chrono::steady_clock::now() - last_report > std::chrono::seconds(10)) {
+			last_report = std::chrono::steady_clock::now();
+			std::cout << "games " << games_done << ", plies " << plies_done << std::endl;
+		}
+	}
+	games.wait();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	std::cout << "games " << games_done << ", plies " << plies_done << ", "
+			  << static_cast<u64>(static_cast<double>(plies_done) / seconds) << " plies/s" << std::endl;
+	if (!failure) return 0;
+
+	std::cout << std::endl << "FAIL seed " << options.seed << " game " << failure->game << " ply " << failure->ply << std::endl;
+	std::cout << "  " << failure->reason << std::endl;
+	std::cout << "  position:  " << failure->fen << std::endl;
+	const string minimized = minimize(failure->fen);
+	Position p(minimized);
+	std::cout << "  minimized: " << minimized << std::endl;
+	std::cout << "  " << check_position(p) << std::endl;
+	return 1;
+}
+
+MIDNIGHT_NAMESPACE_END
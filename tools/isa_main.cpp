@@ -0,0 +1,23 @@
+// Entry point of multi ISA builds (make MULTI_ISA=1, cmake -DMIDNIGHT_MULTI_ISA=ON). The program and the library are
+// compiled once per level of src/utils/isa.h into isa_<level> namespaces, and this main calls the highest level the
+// CPU supports. MIDNIGHT_ISA=<level> selects a lower level. Compiled for the baseline level, like anything shared.
+#include "../src/utils/isa.h"
+#include <iostream>
+
+namespace isa_x86_64 { int isa_main(int argc, char* argv[]); }
+namespace isa_x86_64_v2 { int isa_main(int argc, char* argv[]); }
+namespace isa_x86_64_v3 { int isa_main(int argc, char* argv[]); }
+namespace isa_x86_64_v4 { int isa_main(int argc, char* argv[]); }
+
+int main(int argc, char* argv[]) {
+	switch (selected_isa_level()) {
+		case ISA_X86_64: return isa_x86_64::isa_main(argc, argv);
+		case ISA_X86_64_V2: return isa_x86_64_v2::isa_main(argc, argv);
+		case ISA_X86_64_V3: return isa_x86_64_v3::isa_main(argc, argv);
+		case ISA_X86_64_V4: return isa_x86_64_v4::isa_main(argc, argv);
+		default:
+			std::cerr << "MIDNIGHT_ISA must be a level this CPU supports, up to "
+					  << ISA_NAMES[supported_isa_level()] << std::endl;
+			return 1;
+	}
+}
@@ -0,0 +1,334 @@
+// Perft divide: node counts per root move in UCI notation, for comparing against other move generators.
+// Usage: perft [--counters] [--pin] <fen | startpos> <depth> [threads]
+//        perft [--counters] [--pin] --stats <fen | startpos> <depth> [threads]
+//        perft [--counters] [--pin] --validate <stats file> [threads]
+//        perft [--counters] [--pin] --analyze <fen | startpos> <depth> [threads] [--json]
+// --counters reports hardware performance counters per node, see src/utils/perf_counters.h.
+// The work runs on a thread pool, see src/utils/thread_pool.h, --pin pins its threads to CPUs.
+// Builds with MIDNIGHT_MOVEGEN_PROFILE also report the generator phase counters, see src/move_gen/profile.h.
+#include "../src/board/position.h"
+#include "../src/move_gen/move_generator.h"
+#include "../src/move_gen/parallel.h"
+#include "../src/move_gen/perft.h"
+#include "../src/utils/helpers.h"
+#include "../src/utils/perf_counters.h"
+#include "../src/utils/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// Plain perft is split into subtrees of at least SPLIT_DEPTH plies, taken at most MAX_SPLIT_PLY plies below the root,
+// which keeps the subtrees long next to the cost of a task and their number in the thousands.
+constexpr i32 SPLIT_DEPTH = 3;
+constexpr i32 MAX_SPLIT_PLY = 3;
+
+// Deepest perft, well inside the state history a Position keeps of the moves played.
+constexpr i32 MAX_DEPTH = 64;
+
+struct RootMove {
+	Move move;
+	string uci;
+	u64 nodes = 0;
+	PerftStats stats;
+};
+
+// Perft below every root move, with the full statistics if collect_stats is set.
+template<Color Us>
+std::vector<RootMove> divide(const Position& root, i32 depth, ThreadPool& pool, bool collect_stats) {
+	std::vector<RootMove> root_moves;
+	Position p = root;
+	for (Move move : MoveList<Us, ALL>(p)) {
+		std::ostringstream uci;
+		uci << move;
+		root_moves.push_back({move, uci.str(), 0, {}});
+	}
+
+	if (collect_stats) {
+		parallel_for(pool, root_moves.size(), [&](usize i) {
+			RootMove& root_move = root_moves[i];
+			Position position = root;
+			// Root moves are the leaves at depth 1, so they are counted from the root position.
+			if (depth == 1) count_leaf<Us>(position, root_move.move, root_move.stats);
+			else {
+				position.play<Us>(root_move.move);
+				perft_stats<~Us>(position, depth - 1, root_move.stats);
+			}
+			root_move.nodes = root_move.stats.nodes;
+		});
+	} else {
+		const std::vector<u64> nodes = parallel_divide<Us>(pool, p, depth, std::max(SPLIT_DEPTH, depth - MAX_SPLIT_PLY));
+		for (usize i = 0; i < root_moves.size(); i++) root_moves[i].nodes = nodes[i];
+	}
+
+	std::sort(root_moves.begin(), root_moves.end(), [](const RootMove& a, const RootMove& b) { return a.uci < b.uci; });
+	return root_moves;
+}
+
+void print_speed(std::ostream& os, u64 nodes, std::chrono::steady_clock::duration elapsed) {
+	const auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+	const auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+	os << "Total Nodes: " << nodes << std::endl;
+	os << "Elapsed Time(ms): " << elapsed_ms << std::endl;
+	os << "NPS: " << (elapsed_us ? nodes * 1000000 / elapsed_us : 0) << std::endl;
+}
+
+int run_divide(const string& fen, i32 depth, ThreadPool& pool, bool collect_stats, PerfCounterSet* counters) {
+	const Position root(fen);
+	if (counters) counters->start();
+	const auto start_time = std::chrono::steady_clock::now();
+	const std::vector<RootMove> root_moves = root.turn() == WHITE ? divide<WHITE>(root, depth, pool, collect_stats) :
+											 divide<BLACK>(root, depth, pool, collect_stats);
+	const auto end_time = std::chrono::steady_clock::now();
+	if (counters) counters->stop();
+
+	u64 total_nodes = 0;
+	PerftStats total_stats;
+	for (const RootMove& root_move : root_moves) {
+		std::cout << root_move.uci << ": " << root_move.nodes << std::endl;
+		total_nodes += root_move.nodes;
+		total_stats += root_move.stats;
+	}
+
+	std::cout << std::endl;
+	std::cout << "Moves: " << root_moves.size() << std::endl;
+	if (collect_stats) {
+		std::cout << "Captures: " << total_stats.captures << std::endl;
+		std::cout << "En Passants: " << total_stats.en_passants << std::endl;
+		std::cout << "Castles: " << total_stats.castles << std::endl;
+		std::cout << "Promotions: " << total_stats.promotions << std::endl;
+		std::cout << "Checks: " << total_stats.checks << std::endl;
+		std::cout << "Discovered Checks: " << total_stats.discovered_checks << std::endl;
+		std::cout << "Double Checks: " << total_stats.double_checks << std::endl;
+		std::cout << "Checkmates: " << total_stats.checkmates << std::endl;
+	}
+	print_speed(std::cout, total_nodes, end_time - start_time);
+	if (counters) counters->report(std::cout, total_nodes, "node");
+	if constexpr (MOVEGEN_PROFILE) profile::report(std::cout);
+	return 0;
+}
+
+template<Color Us>
+PerftHistograms analyze(const Position& root, i32 depth, ThreadPool& pool, u64& nodes) {
+	PerftHistograms histograms(depth);
+	Position p = root;
+	std::vector<Move> root_moves;
+	for (Move move : MoveList<Us, ALL>(p)) root_moves.push_back(move);
+	nodes = perft_histograms<Us>(p, 1, histograms);
+	if (depth == 1) return histograms;
+
+	// Every root move fills its own histograms, which are added up afterwards.
+	std::vector<PerftHistograms> root_histograms(root_moves.size(), PerftHistograms(depth));
+	std::vector<u64> root_nodes(root_moves.size());
+	parallel_for(pool, root_moves.size(), [&](usize i) {
+		Position position = root;
+		position.play<Us>(root_moves[i]);
+		root_nodes[i] = perft_histograms<~Us>(position, depth - 1, root_histograms[i], 1);
+	});
+
+	nodes = 0;
+	for (usize i = 0; i < root_moves.size(); i++) {
+		histograms += root_histograms[i];
+		nodes += root_nodes[i];
+	}
+	return histograms;
+}
+
+// Long format, one row per non-empty bucket: ply,histogram,value,nodes.
+void write_csv(std::ostream& os, const PerftHistograms& histograms) {
+	os << "ply,histogram,value,nodes" << std::endl;
+	auto write = [&os](usize ply, const char* name, const auto& buckets) {
+		for (usize value = 0; value < buckets.size(); value++) {
+			if (buckets[value]) os << ply << "," << name << "," << value << "," << buckets[value] << std::endl;
+		}
+	};
+	for (usize ply = 0; ply < histograms.plies.size(); ply++) {
+		const PlyHistogram& h = histograms.plies[ply];
+		write(ply, "moves", h.moves);
+		write(ply, "checkers", h.checkers);
+		write(ply, "pinned", h.pinned);
+		write(ply, "en_passant", h.en_passant);
+	}
+}
+
+// Histograms as objects from value to nodes, with empty buckets left out.
+void write_json(std::ostream& os, const string& fen, i32 depth, const PerftHistograms& histograms) {
+	auto write = [&os](const char* name, const auto& buckets) {
+		os << ", \"" << name << "\": {";
+		bool first = true;
+		for (usize value = 0; value < buckets.size(); value++) {
+			if (!buckets[value]) continue;
+			os << (first ? "" : ", ") << "\"" << value << "\": " << buckets[value];
+			first = false;
+		}
+		os << "}";
+	};
+	os << "{\n  \"fen\": \"" << fen << "\",\n  \"depth\": " << depth << ",\n  \"plies\": [\n";
+	for (usize ply = 0; ply < histograms.plies.size(); ply++) {
+		const PlyHistogram& h = histograms.plies[ply];
+		os << "    {\"ply\": " << ply << ", \"nodes\": " << h.nodes();
+		write("moves", h.moves);
+		write("checkers", h.checkers);
+		write("pinned", h.pinned);
+		write("en_passant", h.en_passant);
+		os << "}" << (ply + 1 < histograms.plies.size() ? "," : "") << "\n";
+	}
+	os << "  ]\n}" << std::endl;
+}
+
+// Histograms go to stdout as CSV or JSON, a per ply summary and the speed go to stderr.
+int run_analyze(const string& fen, i32 depth, ThreadPool& pool, bool json, PerfCounterSet* counters) {
+	const Position root(fen);
+	u64 nodes = 0;
+	if (counters) counters->start();
+	const auto start_time = std::chrono::steady_clock::now();
+	const PerftHistograms histograms = root.turn() == WHITE ? analyze<WHITE>(root, depth, pool, nodes) :
+									   analyze<BLACK>(root, depth, pool, nodes);
+	const auto end_time = std::chrono::steady_clock::now();
+	if (counters) counters->stop();
+
+	if (json) write_json(std::cout, fen, depth, histograms);
+	else write_csv(std::cout, histograms);
+
+	std::cerr << "ply         nodes  moves/node   in check  double check   ep square  ep capture  pinned/node" << std::endl;
+	for (usize ply = 0; ply < histograms.plies.size(); ply++) {
+		const PlyHistogram& h = histograms.plies[ply];
+		const double n = static_cast<double>(h.nodes());
+		double moves = 0, pinned = 0;
+		for (usize i = 0; i < h.moves.size(); i++) moves += static_cast<double>(i * h.moves[i]);
+		for (usize i = 0; i < h.pinned.size(); i++) pinned += static_cast<double>(i * h.pinned[i]);
+		std::cerr << std::setw(3) << ply << std::setw(14) << h.nodes() << std::fixed << std::setprecision(2)
+				  << std::setw(12) << moves / n << std::setw(10) << 100 * (h.checkers[1] + h.checkers[2]) / n << "%"
+				  << std::setw(13) << 100 * h.checkers[2] / n << "%" << std::setw(11) << 100 * (h.en_passant[1] + h.en_passant[2]) / n << "%"
+				  << std::setw(11) << 100 * h.en_passant[2] / n << "%"
+				  << std::setw(13) << pinned / n << std::endl;
+	}
+	std::cerr << std::endl;
+	print_speed(std::cerr, nodes, end_time - start_time);
+	if (counters) counters->report(std::cerr, nodes, "node");
+	if constexpr (MOVEGEN_PROFILE) profile::report(std::cerr);
+	return 0;
+}
+
+struct StatsEntry {
+	string fen;
+	i32 depth = 0;
+	PerftStats expected;
+	PerftStats actual;
+};
+
+// Checks every entry of an extended results file (see tests/perft_stats.txt), one entry per task.
+int run_validate(const string& path, ThreadPool& pool, PerfCounterSet* counters) {
+	std::ifstream input_file(path);
+	if (!input_file) {
+		std::cerr << "Cannot open " << path << std::endl;
+		return 1;
+	}
+
+	std::vector<StatsEntry> entries;
+	std::string input_line;
+	while (std::getline(input_file, input_line)) {
+		std::vector<string> split_line = split(input_line, ";");
+		for (usize i = 1; i < split_line.size(); i++) {
+			std::istringstream columns(split_line[i]);
+			string depth;
+			StatsEntry entry{split_line[0], static_cast<i32>(i), {}, {}};
+			PerftStats& e = entry.expected;
+			columns >> depth >> e.nodes >> e.captures >> e.en_passants >> e.castles >> e.promotions >> e.checks
+					>> e.discovered_checks >> e.double_checks >> e.checkmates;
+			entries.push_back(entry);
+		}
+	}
+
+	// Largest entries first, so no thread is left with a deep entry at the end.
+	std::sort(entries.begin(), entries.end(), [](const StatsEntry& a, const StatsEntry& b) {
+		return a.expected.nodes > b.expected.nodes;
+	});
+
+	if (counters) counters->start();
+	const auto start_time = std::chrono::steady_clock::now();
+	parallel_for(pool, entries.size(), [&](usize i) {
+		Position p(entries[i].fen);
+		if (p.turn() == WHITE) perft_stats<WHITE>(p, entries[i].depth, entries[i].actual);
+		else perft_stats<BLACK>(p, entries[i].depth, entries[i].actual);
+	});
+	const auto end_time = std::chrono::steady_clock::now();
+	if (counters) counters->stop();
+
+	usize failures = 0;
+	u64 total_nodes = 0;
+	for (const StatsEntry& entry : entries) {
+		total_nodes += entry.actual.nodes;
+		if (entry.actual == entry.expected) continue;
+		failures++;
+		std::cout << "FAIL " << entry.fen << " D" << entry.depth << std::endl;
+		std::cout << "  expected " << entry.expected << std::endl;
+		std::cout << "  actual   " << entry.actual << std::endl;
+	}
+
+	std::cout << entries.size() - failures << "/" << entries.size() << " entries passed" << std::endl;
+	print_speed(std::cout, total_nodes, end_time - start_time);
+	if (counters) counters->report(std::cout, total_nodes, "node");
+	if constexpr (MOVEGEN_PROFILE) profile::report(std::cout);
+	return failures ? 1 : 0;
+}
+
+int MIDNIGHT_MAIN(int argc, char* argv[]) {
+	std::vector<string> args(argv + 1, argv + argc);
+	const auto counters_flag = std::find(args.begin(), args.end(), "--counters");
+	const bool use_counters = counters_flag != args.end();
+	if (use_counters) args.erase(counters_flag);
+	const auto pin_flag = std::find(args.begin(), args.end(), "--pin");
+	const bool pin = pin_flag != args.end();
+	if (pin) args.erase(pin_flag);
+	const auto json_flag = std::find(args.begin(), args.end(), "--json");
+	const bool json = json_flag != args.end();
+	if (json) args.erase(json_flag);
+
+	const string mode = args.empty() ? "" : args[0];
+	const bool validate = mode == "--validate";
+	const bool collect_stats = mode == "--stats";
+	const bool analysis = mode == "--analyze";
+	const usize first = validate || collect_stats || analysis ? 1 : 0;
+	const usize required = validate ? 1 : 2;
+	// Only the analysis has JSON output.
+	if (args.size() < first + required || (json && !analysis)) {
+		std::cerr << "Usage: " << argv[0] << " [--counters] [--pin] [--stats] <fen | startpos> <depth> [threads]" << std::endl;
+		std::cerr << "       " << argv[0] << " [--counters] [--pin] --validate <stats file> [threads]" << std::endl;
+		std::cerr << "       " << argv[0] << " [--counters] [--pin] --analyze <fen | startpos> <depth> [threads] [--json]" << std::endl;
+		return 1;
+	}
+
+	i32 depth = 1;
+	usize threads = default_thread_count();
+	try {
+		if (!validate) depth = std::stoi(args[first + 1]);
+		if (args.size() > first + required) threads = parse_thread_count(args[first + required]);
+	} catch (const std::exception&) {
+		depth = 0;
+	}
+	if (depth < 1 || depth > MAX_DEPTH || threads < 1) {
+		std::cerr << "Depth and threads must be positive numbers, depth at most " << MAX_DEPTH << " and threads at most "
+				  << MAX_THREADS << "." << std::endl;
+		return 1;
+	}
+
+	// Counters are opened before the worker threads exist, so the workers inherit them.
+	std::optional<PerfCounterSet> counters;
+	if (use_counters) counters.emplace(true);
+	PerfCounterSet* counters_ptr = counters ? &*counters : nullptr;
+	ThreadPool pool(threads, pin);
+
+	if (validate) return run_validate(args[first], pool, counters_ptr);
+	const string fen = args[first] == "startpos" ? START_FEN : args[first];
+	if (analysis) return run_analyze(fen, depth, pool, json, counters_ptr);
+	return run_divide(fen, depth, pool, collect_stats, counters_ptr);
+}
+
+MIDNIGHT_NAMESPACE_END
@@ -0,0 +1,283 @@
+// Long running query server, so clients pay for process startup once instead of per query. Reads newline delimited
+// commands from stdin and answers every query with one line on stdout, in the order of the queries.
+//   position startpos|fen <fen> [moves <uci>...]   sets the position of the following queries, no answer
+//   moves                                          legal moves in UCI notation separated by spaces, e.g. "e2e4 d2d4"
+//   perft <depth>                                  number of leaf nodes
+//   divide <depth>                                 <move>:<nodes> per legal move separated by spaces
+//   isready                                        "readyok", once the answers before it are written
+//   quit
+// Malformed commands, and queries of positions that are malformed or have an illegal move, answer "error <reason>".
+// Usage: server [--threads N] [--batch N]
+// Lines that have already arrived, up to --batch, are answered as one batch with one write, so a client that
+// pipelines its queries is not limited by round trips. With --threads the queries of a batch are spread in chunks over
+// a thread pool, see src/utils/thread_pool.h. Every thread keeps its own Position and loads a position command once
+// for consecutive queries.
+// Commands are parsed in place and answers written to buffers kept across batches, so requests do not allocate once
+// the buffers have grown.
+#include "../src/board/position.h"
+#include "../src/board/validation.h"
+#include "../src/move_gen/move_generator.h"
+#include "../src/move_gen/perft.h"
+#include "../src/utils/helpers.h"
+#include "../src/utils/thread_pool.h"
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+MIDNIGHT_NAMESPACE_BEGIN
+
+// Moves a position command can play, and the largest depth, which keep the state history of a Position in bounds.
+constexpr usize MAX_POSITION_MOVES = 512;
+constexpr i32 MAX_DEPTH = 64;
+// Queries a thread takes at a time. Consecutive queries usually share a position, which is then loaded once.
+constexpr usize CHUNK_SIZE = 16;
+constexpr usize NO_POSITION = ~usize(0);
+
+enum class QueryType : u8 { MOVES, PERFT, DIVIDE, READY, ERROR };
+
+struct Query {
+	QueryType type;
+	i32 depth = 0;
+	// Index of the position command of the batch the query is asked about.
+	usize position = 0;
+	std::string_view error;
+};
+
+// Removes the next token separated by spaces from the front of text.
+std::string_view next_token(std::string_view& text) {
+	const usize start = std::min(text.find_first_not_of(' '), text.size());
+	text.remove_prefix(start);
+	const std::string_view token = text.substr(0, text.find(' '));
+	text.remove_prefix(token.size());
+	return token;
+}
+
+template<Color Us>
+bool play_uci(Position& p, std::string_view uci) {
+	for (Move move : MoveList<Us, ALL>(p)) {
+		if (!matches_uci(move, uci)) continue;
+		p.play<Us>(move);
+		return true;
+	}
+	return false;
+}
+
+// Sets p to the arguments of a position command, false when they are malformed, the position is not one a game can
+// reach or a move is not legal.
+bool load(Position& p, std::string_view command) {
+	std::string_view text = command;
+	const std::string_view setup = next_token(text);
+	std::string_view fen = START_FEN;
+	if (setup == "fen") {
+		const usize moves_at = std::min(text.find(" moves"), text.size());
+		fen = text.substr(0, moves_at);
+		text.remove_prefix(moves_at);
+		fen.remove_prefix(std::min(fen.find_first_not_of(' '), fen.size()));
+		fen = fen.substr(0, fen.find_last_not_of(' ') + 1);
+	} else if (setup != "startpos") {
+		return false;
+	}
+	if (!is_valid_fen(fen)) return false;
+	p.set_fen(fen);
+	if (!is_valid_position(p)) return false;
+
+	const std::string_view keyword = next_token(text);
+	if (keyword.empty()) return true;
+	if (keyword != "moves") return false;
+	usize played = 0;
+	for (std::string_view uci = next_token(text); !uci.empty(); uci = next_token(text)) {
+		if (++played > MAX_POSITION_MOVES) return false;
+		if (!(p.turn() == WHITE ? play_uci<WHITE>(p, uci) : play_uci<BLACK>(p, uci))) return false;
+	}
+	return true;
+}
+
+void append_move(string& out, Move move) {
+	out += SQ_TO_STRING[move.from()];
+	out += SQ_TO_STRING[move.to()];
+	out += MOVE_TYPE_UCI[move.type()];
+}
+
+void append_number(string& out, u64 number) {
+	char digits[20];
+	const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+	out.append(digits, result.ptr);
+}
+
+template<Color Us>
+void answer(Position& p, const Query& query, string& out) {
+	if (query.type == QueryType::PERFT) {
+		append_number(out, perft<Us>(p, query.depth));
+		return;
+	}
+	for (Move move : MoveList<Us, ALL>(p)) {
+		if (!out.empty()) out += ' ';
+		append_move(out, move);
+		if (query.type != QueryType::DIVIDE) continue;
+		p.play<Us>(move);
+		out += ':';
+		append_number(out, perft<~Us>(p, query.depth - 1));
+		p.undo<Us>(move);
+	}
+}
+
+struct Worker {
+	Position position;
+	// The position command loaded into position, NO_POSITION before the first query of a batch.
+	usize loaded = NO_POSITION;
+	bool valid = false;
+};
+
+class Server {
+private:
+	usize max_batch;
+	// Arguments of the position commands of the batch. The first is the last position of the previous batch, which
+	// queries before the first position command of a batch are asked about.
+	std::vector<string> positions{"startpos"};
+	usize n_positions = 1;
+	std::vector<Query> queries;
+	std::vector<string> answers;
+	string line, output;
+	bool quit = false;
+
+	// Without a pool the main thread answers every query. One worker per thread of the pool, and the last one for the
+	// main thread.
+	std::unique_ptr<ThreadPool> pool;
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	void parse(std::string_view text) {
+		const std::string_view command = next_token(text);
+		if (command.empty()) return;
+		if (command == "quit") {
+			quit = true;
+			return;
+		}
+		if (command == "position") {
+			if (n_positions == positions.size()) positions.emplace_back();
+			positions[n_positions++].assign(text);
+			return;
+		}
+
+		Query query{QueryType::ERROR, 0, n_positions - 1, "unknown command"};
+		if (command == "moves") {
+			query.type = QueryType::MOVES;
+		} else if (command == "isready") {
+			query.type = QueryType::READY;
+		} else if (command == "perft" || command == "divide") {
+			const std::string_view depth = next_token(text);
+			const auto result = std::from_chars(depth.data(), depth.data() + depth.size(), query.depth);
+			const i32 min_depth = command == "perft" ? 0 : 1;
+			if (result.ec != std::errc() || result.ptr != depth.data() + depth.size() || query.depth < min_depth ||
+				query.depth > MAX_DEPTH) {
+				query.error = "invalid depth";
+			} else {
+				query.type = command == "perft" ? QueryType::PERFT : QueryType::DIVIDE;
+			}
+		}
+		queries.push_back(query);
+	}
+
+	// Blocks for the first line, then takes the lines that have already arrived. False at the end of the input.
+	bool read_batch() {
+		std::swap(positions[0], positions[n_positions - 1]);
+		n_positions = 1;
+		queries.clear();
+		for (usize lines = 0; lines < max_batch && !quit; lines++) {
+			if (!std::getline(std::cin, line)) return !queries.empty();
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			parse(line);
+			if (std::cin.rdbuf()->in_avail() <= 0) break;
+		}
+		return true;
+	}
+
+	void process(Worker& worker, usize i) {
+		const Query& query = queries[i];
+		string& out = answers[i];
+		out.clear();
+		if (query.type == QueryType::READY) {
+			out += "readyok";
+			return;
+		}
+		if (query.type == QueryType::ERROR) {
+			out += "error ";
+			out += query.error;
+			return;
+		}
+		if (worker.loaded != query.position) {
+			worker.valid = load(worker.position, positions[query.position]);
+			worker.loaded = query.position;
+		}
+		if (!worker.valid) {
+			// The position may have been changed by moves before the illegal one, it is loaded again when asked.
+			worker.loaded = NO_POSITION;
+			out += "error invalid position";
+			return;
+		}
+		if (worker.position.turn() == WHITE) answer<WHITE>(worker.position, query, out);
+		else answer<BLACK>(worker.position, query, out);
+	}
+
+	void answer_batch() {
+		if (answers.size() < queries.size()) answers.resize(queries.size());
+		for (std::unique_ptr<Worker>& worker : workers) worker->loaded = NO_POSITION;
+		const usize chunks = (queries.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+		// Small batches, e.g. of a client waiting for every answer, are not worth waking the threads.
+		if (!pool || chunks <= 1) {
+			for (usize i = 0; i < queries.size(); i++) process(*workers.back(), i);
+			return;
+		}
+		parallel_for(*pool, chunks, [&](usize chunk) {
+			Worker& worker = *workers[pool->thread_index()];
+			for (usize i = chunk * CHUNK_SIZE; i < std::min((chunk + 1) * CHUNK_SIZE, queries.size()); i++) process(worker, i);
+		});
+	}
+
+public:
+	Server(usize n_threads, usize max_batch) : max_batch(max_batch) {
+		if (n_threads > 1) pool = std::make_unique<ThreadPool>(n_threads);
+		for (usize t = 0; t < (pool ? pool->size() : 0) + 1; t++) workers.push_back(std::make_unique<Worker>());
+	}
+
+	void run() {
+		while (!quit && read_batch()) {
+			answer_batch();
+			output.clear();
+			for (usize i = 0; i < queries.size(); i++) {
+				output += answers[i];
+				output += '\n';
+			}
+			std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+			std::cout.flush();
+		}
+	}
+};
+
+int MIDNIGHT_MAIN(int argc, char* argv[]) {
+	usize threads = 1, max_batch = 4096;
+	bool valid = argc % 2 == 1;
+	for (int i = 1; i + 1 < argc && valid; i += 2) {
+		const string option = argv[i];
+		try {
+			if (option == "--threads") threads = parse_thread_count(argv[i + 1]);
+			else if (option == "--batch") max_batch = static_cast<usize>(std::max(std::stoi(argv[i + 1]), 0));
+			else valid = false;
+		} catch (const std::exception&) {
+			valid = false;
+		}
+	}
+	if (!valid || threads < 1 || max_batch < 1) {
+		std::cerr << "Usage: " << argv[0] << " [--threads N] [--batch N]" << std::endl;
+		return 1;
+	}
+
+	std::ios::sync_with_stdio(false);
+	std::cin.tie(nullptr);
+	Server(threads, max_batch).run();
+	return 0;
+}
+
+MIDNIGHT_NAMESPACE_END